@@ -1,6 +1,25 @@
 ﻿#define FREEGLUT_STATIC
 #define STB_IMAGE_IMPLEMENTATION
 #define GLEW_STATIC
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <malloc.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET socket_t;
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#define closesocket ::close
+#endif
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -11,809 +30,5439 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <sstream>
 #include <ft2build.h>
 #include "stb_image.h"
 #include FT_FREETYPE_H
-#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <type_traits>
+#include <atomic>
+#include <new>
+#include <cstdarg>
+#include <cstddef>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <cstdio>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 
 using namespace std;
 
-class Window {
+// Tüm heap ayırmalarını sayan global operator new; kare başına fark --alloc-check ile denetlenir
+static std::atomic<size_t> heapAllocCount(0);
+
+#ifdef _MSC_VER
+#define CATCHME_NOINLINE __declspec(noinline)
+#else
+#define CATCHME_NOINLINE __attribute__((noinline))
+#endif
+
+// Tüm delete'ler bu yoldan (hizalılar heapAlignedFree'den) iner. Satır içine alınırsa GCC, operator new'in
+// döndürdüğü işaretçinin doğrudan free'ye gittiğini görür ve -Wmismatched-new-delete uyarır
+static CATCHME_NOINLINE void heapFree(void* p) noexcept { free(p); }
+
+void* operator new(size_t size) {
+    heapAllocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    heapAllocCount.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { heapFree(p); }
+void operator delete[](void* p) noexcept { heapFree(p); }
+void operator delete(void* p, size_t) noexcept { heapFree(p); }
+void operator delete[](void* p, size_t) noexcept { heapFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { heapFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { heapFree(p); }
+
+#ifdef __cpp_aligned_new
+// Aşırı hizalı türler (alignas > varsayılan) ayrı operatörlerden geçer; onlar da sayılır
+static CATCHME_NOINLINE void heapAlignedFree(void* p) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    heapAllocCount.fetch_add(1, std::memory_order_relaxed);
+    size_t a = static_cast<size_t>(align);
+    if (!size) size = 1;
+#ifdef _WIN32
+    return _aligned_malloc(size, a);
+#else
+    void* p = nullptr;
+    return posix_memalign(&p, a < sizeof(void*) ? sizeof(void*) : a, size) == 0 ? p : nullptr;
+#endif
+}
+void* operator new(size_t size, std::align_val_t align) {
+    if (void* p = operator new(size, align, std::nothrow)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t align) { return operator new(size, align); }
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t& tag) noexcept { return operator new(size, align, tag); }
+void operator delete(void* p, std::align_val_t) noexcept { heapAlignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { heapAlignedFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { heapAlignedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { heapAlignedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { heapAlignedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { heapAlignedFree(p); }
+#endif
+
+// Kare boyunca yaşayan geçici veriler için doğrusal ayırıcı; her kare başında sıfırlanır
+class FrameArena {
 public:
-    GLFWwindow* window;
-    int w, h;
+    FrameArena(size_t capacity) : used(0), peak(0), overflows(0), buffer(new char[capacity]), capacity(capacity) {}
 
-    Window(int width, int height, const char* title) : w(width), h(height) {
-        glfwInit();
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    void reset() { used = 0; }
 
-        window = glfwCreateWindow(w, h, title, NULL, NULL); glfwMakeContextCurrent(window); glewInit();
+    void* alloc(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t start = (used + align - 1) & ~(align - 1);
+        if (start + size > capacity) {
+            ++overflows; // Kapasite yetmedi: çağıran sabit bir yedeğe düşmeli
+            return nullptr;
+        }
+        used = start + size;
+        peak = std::max(peak, used);
+        return buffer.get() + start;
+    }
 
-        glViewport(0, 0, w, h); glEnable(GL_DEPTH_TEST); glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    template<typename T>
+    T* allocArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        return static_cast<T*>(alloc(count * sizeof(T), alignof(T)));
     }
 
-    bool shouldClose() { return glfwWindowShouldClose(window); }
-    void swap() { glfwSwapBuffers(window); }
-    void poll() { glfwPollEvents(); }
-    ~Window() { glfwDestroyWindow(window); glfwTerminate(); }
+    // printf biçimli, kare sonuna kadar geçerli metin
+    const char* format(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        va_list copy;
+        va_copy(copy, args);
+        int len = vsnprintf(nullptr, 0, fmt, copy);
+        va_end(copy);
+        char* out = len >= 0 ? allocArray<char>(len + 1) : nullptr;
+        if (out) vsnprintf(out, len + 1, fmt, args);
+        va_end(args);
+        return out ? out : "";
+    }
+
+    size_t used, peak, overflows;
+
+private:
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
 };
 
-class Shader {
+// Zaman çizelgesi izleri: TRACE_SCOPE("ad") kapsam süresini iş parçacığının kendi halkasına yazar (kilitsiz, tek yazar).
+// Halka TRACE_THREAD ile iş parçacığı girişinde ayrılır; adlandırılmamış iş parçacıklarının izleri atılır (kare ortasında new yok).
+// Halka son CAPACITY olayı tutar; dump son N saniyeyi Chrome trace-event JSON'u olarak yazar (Perfetto/chrome://tracing).
+// Zaman damgası x86'da TSC sayacıdır (rdtsc, steady_clock'tan birkaç kat ucuz); ilk izde alınan (tsc, ns) çifti ile
+// dump anındaki çift arasındaki orandan nanosaniyeye çevrilir. Diğer mimarilerde damga doğrudan steady_clock ns'sidir.
+// CATCHME_NO_TRACE ile derlenirse makrolar hiçbir şey üretmez.
+class Trace {
 public:
-    GLuint ID;
-
-    Shader(const char* vertex, const char* fragment) {
-        GLuint vShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vShader, 1, &vertex, NULL); glCompileShader(vShader);
+    enum { CAPACITY = 1 << 16, MAX_THREADS = 64 };
+    // dump'ın kopyası; name dize sabitidir (kopyalanmaz), index halkadaki sıra numarasıdır
+    struct Record {
+        const char* name;
+        uint64_t start, end, index;
+    };
+    // seq yazım sırasında tektir; okuyucu kopyadan önce ve sonra aynı çift değeri görmezse olayı atar (seqlock)
+    struct Event {
+        std::atomic<uint32_t> seq;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> start, end;
+    };
+    struct ThreadLog {
+        std::atomic<uint64_t> head;
+        std::atomic<const char*> name;
+        Event events[CAPACITY];
+    };
 
-        GLuint fShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fShader, 1, &fragment, NULL); glCompileShader(fShader);
+    static bool& enabled() {
+        static bool value = true;
+        return value;
+    }
 
-        ID = glCreateProgram();
-        glAttachShader(ID, vShader); glAttachShader(ID, fShader); glLinkProgram(ID);
+    static uint64_t now() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return nanoseconds();
+#endif
+    }
 
-        glDeleteShader(vShader); glDeleteShader(fShader);
+    static void record(const char* name, uint64_t start, uint64_t end) {
+        ThreadLog* log = local();
+        if (!log) return;
+        uint64_t h = log->head.load(std::memory_order_relaxed);
+        Event& e = log->events[h & (CAPACITY - 1)];
+        uint32_t seq = e.seq.load(std::memory_order_relaxed);
+        e.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        e.name.store(name, std::memory_order_relaxed);
+        e.start.store(start, std::memory_order_relaxed);
+        e.end.store(end, std::memory_order_relaxed);
+        e.seq.store(seq + 2, std::memory_order_release);
+        log->head.store(h + 1, std::memory_order_release);
     }
 
-    void use() { glUseProgram(ID); }
-    void setMat4(string name, const glm::mat4& mat) {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    // İş parçacığı girişinde çağrılır: halkayı ayırıp kaydeder (izler kapalıysa ayırmaz) ve adlandırır
+    static void nameThread(const char* name) {
+        ThreadLog*& log = local();
+        if (!log && enabled()) log = attach();
+        if (log) log->name.store(name, std::memory_order_release);
     }
-    void setVec4(string name, const glm::vec4& value) {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+
+    // Yazarlar durmaz: kopyalama sırasında üzerine yazılmış olabilecek eski olaylar sonradan ayıklanır
+    static bool dump(const char* path, double seconds) {
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        const Origin& o = origin();
+        uint64_t end = now(), endNs = nanoseconds();
+        double nsPerTick = end > o.ticks && endNs > o.ns ? static_cast<double>(endNs - o.ns) / (end - o.ticks) : 1.0;
+        uint64_t cutoff = end - std::min(end, static_cast<uint64_t>(glm::max(seconds, 0.0) * 1e9 / nsPerTick)), base = UINT64_MAX;
+        vector<Record> events;
+        vector<std::pair<size_t, size_t>> ranges;
+        int threads = registered().load(std::memory_order_acquire);
+        for (int t = 0; t < threads; ++t) {
+            ThreadLog* log = logs()[t];
+            uint64_t h = log->head.load(std::memory_order_acquire), first = h > CAPACITY ? h - CAPACITY : 0;
+            size_t begin = events.size();
+            for (uint64_t i = first; i < h; ++i) {
+                const Event& e = log->events[i & (CAPACITY - 1)];
+                uint32_t seq = e.seq.load(std::memory_order_acquire);
+                if (seq & 1) continue;
+                Record r = { e.name.load(std::memory_order_relaxed), e.start.load(std::memory_order_relaxed), e.end.load(std::memory_order_relaxed), i };
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (e.seq.load(std::memory_order_relaxed) == seq) events.push_back(r);
+            }
+            // Kopya sırasında üzerine yazılan (ve o an yazılmakta olan after yuvası) eski sıra numaralı olaylar atılır
+            uint64_t after = log->head.load(std::memory_order_acquire), oldest = after + 1 > CAPACITY ? after + 1 - CAPACITY : 0;
+            size_t fresh = begin;
+            while (fresh < events.size() && events[fresh].index < oldest) ++fresh;
+            ranges.push_back(std::make_pair(fresh, events.size()));
+            for (size_t i = ranges.back().first; i < events.size(); ++i) if (events[i].end >= cutoff) base = std::min(base, events[i].start);
+        }
+        fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        bool first = true;
+        for (int t = 0; t < threads; ++t) {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", t, logs()[t]->name.load(std::memory_order_acquire));
+            first = false;
+            for (size_t i = ranges[t].first; i < ranges[t].second; ++i) {
+                const Record& e = events[i];
+                if (e.end < cutoff) continue;
+                fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", e.name, t,
+                    (e.start - base) * nsPerTick / 1000.0, (e.end - e.start) * nsPerTick / 1000.0);
+            }
+        }
+        fprintf(f, "\n]}\n");
+        fclose(f);
+        return true;
     }
-    ~Shader() { glDeleteProgram(ID); }
-};
 
-class Camera {
-public:
-    glm::vec3 pos;
-    glm::vec3 front;
-    glm::vec3 up;
-    glm::mat4 view;
-    glm::mat4 proj;
-    float w, h;
-    float yaw, pitch;
-    double lastX, lastY;
-    bool firstMouse;
-    glm::vec3 target;
-    float dist;
-    float mouseSensitivity; 
+private:
+    struct Origin {
+        uint64_t ticks, ns;
+    };
 
-    Camera(float width, float height) : pos(0.0f, 5.0f, -5.0f), front(0.0f, 0.0f, -1.0f), up(0.0f, 1.0f, 0.0f),
-        w(width), h(height), yaw(-90.0f), pitch(-15.0f), lastX(width / 2.0), lastY(height / 2.0), firstMouse(true),
-        target(0.0f, 0.5f, 0.0f), dist(7.0f), mouseSensitivity(0.5f) { 
-        proj = glm::perspective(glm::radians(45.0f), w / h, 0.1f, 100.0f);
-        updateView(0.016f);
+    static uint64_t nanoseconds() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
     }
 
-    void updateView(float dt) {
-        glm::vec3 dir;
-        dir.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-        dir.y = sin(glm::radians(pitch));
-        dir.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-        front = glm::normalize(dir);
+    // Ölçek için başlangıç çifti; attach ilk kayıtta kurar, böylece dump'a kadar geçen süre oranı doğru verir
+    static const Origin& origin() {
+        static const Origin value = { now(), nanoseconds() };
+        return value;
+    }
 
-        glm::vec3 desiredPos = target - (front * dist);
-        desiredPos.y = target.y + 3.0f; 
+    static std::atomic<int>& registered() {
+        static std::atomic<int> count(0);
+        return count;
+    }
 
-        // Wall conflict
-        const float wallRadius = 10.0f; 
-        const float wallThickness = 0.5f; 
-        float cameraDist = glm::length(glm::vec2(desiredPos.x, desiredPos.z));
-        if (cameraDist > wallRadius - wallThickness) {
-            // Kamerayı duvarın dışına it
-            float angle = atan2(desiredPos.z, desiredPos.x);
-            desiredPos.x = (wallRadius - wallThickness - 0.5f) * cos(angle); // 0.5f kamera yarıçapı
-            desiredPos.z = (wallRadius - wallThickness - 0.5f) * sin(angle);
-            // dist değerini değiştirmiyoruz, sabit kalıyor
-        }
+    static ThreadLog** logs() {
+        static ThreadLog* all[MAX_THREADS];
+        return all;
+    }
 
-        pos = desiredPos;
-        view = glm::lookAt(pos, target, up);
+    // Sabit ilklenir: erişim ilk kullanım denetimi ya da ayırma yapmaz
+    static ThreadLog*& local() {
+        static thread_local ThreadLog* log = nullptr;
+        return log;
     }
 
-    void mouseInput(Window& win, double xpos, double ypos) {
-        if (firstMouse) {
-            lastX = xpos;
-            lastY = ypos;
-            firstMouse = false;
-        }
+    // Halka bir kez ayrılır ve listeye eklenir (iş parçacığı bitse de dump için kalır); seq'ler sıfırdan başlar
+
+    static ThreadLog* attach() {
+        origin();
+        static std::mutex mutex;
+        std::lock_guard<std::mutex> lock(mutex);
+        int index = registered().load(std::memory_order_relaxed);
+        if (index == MAX_THREADS) return nullptr;
+        ThreadLog* log = new ThreadLog();
+        log->name.store("thread", std::memory_order_relaxed);
+        logs()[index] = log;
+        registered().store(index + 1, std::memory_order_release);
+        return log;
+    }
+};
 
-        float xoff = static_cast<float>(xpos - lastX);
-        float yoff = static_cast<float>(lastY - ypos);
-        lastX = xpos;
-        lastY = ypos;
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), start(Trace::enabled() ? Trace::now() : 0) {}
+    ~TraceScope() { if (start) Trace::record(name, start, Trace::now()); }
 
-        // Apply mouseSensitivity to scale the offsets
-        xoff *= 0.2f * mouseSensitivity;
-        yoff *= 0.2f * mouseSensitivity;
+private:
+    const char* name;
+    uint64_t start;
+};
 
-        yaw += xoff;
-        pitch += yoff;
+#ifndef CATCHME_NO_TRACE
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_JOIN(traceScope, __LINE__)(name)
+#define TRACE_THREAD(name) Trace::nameThread(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#endif
+
+// Chase–Lev iş çalma kuyruğu (Lê ve ark. 2013, C11 bellek modeliyle): sahibi alttan ekler ve çeker (LIFO),
+// hırsızlar üstten çalar (FIFO). Sabit kapasite, büyümez: doluysa push false döner, çağıran işi kendisi çalıştırır.
+// Tek eleman kaldığında sahip ile hırsız aynı top CAS'ında yarışır; tam olarak biri kazanır.
+struct Job;
+
+class JobDeque {
+public:
+    enum { CAPACITY = 1024 };
 
-        if (pitch > 45.0f) pitch = 45.0f;
-        if (pitch < -45.0f) pitch = -45.0f;
+    JobDeque() : top(0), bottom(0) {
+        for (std::atomic<Job*>& slot : slots) slot.store(nullptr, std::memory_order_relaxed);
+    }
 
-        updateView(0.016f);
+    // Yalnızca sahibi
+    bool push(Job* job) {
+        int64_t b = bottom.load(std::memory_order_relaxed), t = top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY) return false;
+        slots[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release); // İş ve yuva, bottom'u acquire ile okuyan hırsıza görünür
+        return true;
     }
 
-    void setTarget(const glm::vec3& newTarget) {
-        target = newTarget + glm::vec3(0.0f, 0.5f, 0.0f);
+    // Yalnızca sahibi
+    Job* pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job* job = slots[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
     }
 
-    glm::vec3 getRight() const {
-        return glm::normalize(glm::cross(up, front));
+    // Herhangi bir iş parçacığı; yarışı kaybederse nullptr
+    Job* steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        Job* job = slots[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+        return job;
     }
-};
 
-class Mesh {
-public:
-    GLuint VAO, VBO, EBO;
-    vector<GLfloat> verts;
-    vector<GLuint> inds;
+    bool empty() const {
+        return bottom.load(std::memory_order_acquire) <= top.load(std::memory_order_acquire);
+    }
 
-    Mesh(const vector<GLfloat>& vertices, const vector<GLuint>& indices) : verts(vertices), inds(indices) {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+private:
+    std::atomic<int64_t> top;
+    char pad[64]; // top (hırsızlar) ile bottom (sahip) ayrı önbellek satırlarında
+    std::atomic<int64_t> bottom;
+    std::atomic<Job*> slots[CAPACITY];
+};
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
+// Bekleyen iş sayacı: spawn artırır, iş bitince azalır; wait sıfıra inene kadar çağıranı da çalıştırır
+struct JobCounter {
+    std::atomic<int> pending;
+    JobCounter() : pending(0) {}
+};
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, inds.size() * sizeof(GLuint), inds.data(), GL_STATIC_DRAW);
+struct Job {
+    void (*fn)(void* ctx, size_t a, size_t b);
+    void* ctx;
+    size_t a, b;
+    JobCounter* counter;
+    std::atomic<bool> busy; // Kuyrukta ya da çalışırken halka yuvası yeniden verilmez
+};
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(0);
+// Motorun ortak zamanlayıcısı: işçi başına bir Chase–Lev kuyruğu; boşta kalan kendi kuyruğundan sonra rastgele bir
+// kurbandan çalar. Ana iş parçacığı (start'ı çağıran) 0. yuvadır ve wait içinde iş yürütür; işler her iş parçacığının
+// kendi halkasından alınır, kare başına ayırma ya da iş parçacığı açma yok. İş bulamayan işçi kısa dönüp uyur.
+// parallelFor aralığı grain boyunda parçalara ikiye bölerek dağıtır: gövde parça başına bir kez, parça sınırları grain'in
+// katlarıdır; sonucu parça sırasına göre yazan çağıranlar iş parçacığı sayısından bağımsızdır.
+class JobSystem {
+public:
+    enum { JOB_RING = 1024, MAX_WORKERS = 64 };
 
-        glBindVertexArray(0);
+    static JobSystem& current() {
+        static JobSystem system;
+        return system;
     }
 
-    void draw() {
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, inds.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    // Toplam iş parçacığı sayısı = workers + 1 (çağıran); 0 işçi: her şey çağıranda, seri
+    void start(int workers) {
+        stop();
+        workers = glm::clamp(workers, 0, MAX_WORKERS - 1);
+        quit.store(false, std::memory_order_relaxed);
+        for (int i = 0; i <= workers; ++i) {
+            slots.emplace_back(new Worker);
+            slots.back()->rng = 0x9E3779B9u * static_cast<uint32_t>(i + 1);
+        }
+        threadIndex() = 0;
+        for (int i = 1; i <= workers; ++i) threads.emplace_back(&JobSystem::loop, this, i);
     }
 
-    ~Mesh() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
-    }
-};
+    int size() const { return static_cast<int>(threads.size()) + 1; }
 
-class TextureMesh {
-public:
-    GLuint VAO, VBO, EBO;
-    vector<GLfloat> verts;
-    vector<GLuint> inds;
+    // fn(ctx, a, b) kayıtlı bir iş parçacığında çalışır; counter (varsa) bitene kadar bekler durumda kalır
+    void spawn(void (*fn)(void*, size_t, size_t), void* ctx, size_t a, size_t b, JobCounter* counter) {
+        int self = threadIndex();
+        Job* job = threads.empty() || self < 0 ? nullptr : allocate(*slots[self]);
+        if (!job) {
+            fn(ctx, a, b);
+            return;
+        }
+        job->fn = fn; job->ctx = ctx; job->a = a; job->b = b; job->counter = counter;
+        if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+        if (!slots[self]->deque.push(job)) {
+            execute(job);
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed) > 0) {
+            { std::lock_guard<std::mutex> lock(mutex); ++epoch; }
+            wake.notify_one();
+        }
+    }
 
-    // Varsayılan constructor (UI için, 2D vertex'ler)
-    TextureMesh() {
-        // 2D dörtgen için vertex'ler: pozisyon (x, y) ve doku koordinatları (u, v)
-        verts = {
-            -125.0f, -125.0f,  0.0f, 0.0f,  // Sol alt (150x150 piksel)
-             125.0f, -125.0f,  1.0f, 0.0f,  // Sağ alt
-             125.0f,  125.0f,  1.0f, 1.0f,  // Sağ üst
-            -125.0f,  125.0f,  0.0f, 1.0f   // Sol üst
-        };
+    // Sayaç sıfırlanana kadar bekleyen işleri (önce kendi kuyruğunu) yürütür
+    void wait(JobCounter& counter) {
+        int self = threadIndex();
+        while (counter.pending.load(std::memory_order_acquire) > 0) {
+            Job* job = self >= 0 && !threads.empty() ? find(self) : nullptr;
+            if (job) execute(job);
+            else std::this_thread::yield();
+        }
+    }
 
-        inds = {
-            0, 1, 2,
-            2, 3, 0
-        };
+    // body(begin, end) her parça için bir kez; tüm parçalar bitmeden dönmez
+    template<typename F>
+    void parallelFor(size_t count, size_t grain, F& body) {
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (count + grain - 1) / grain;
+        if (threads.empty() || chunks <= 1 || threadIndex() < 0) {
+            for (size_t b = 0; b < count; b += grain) body(b, std::min(b + grain, count));
+            return;
+        }
+        Range range;
+        range.body = &body;
+        range.call = [](void* ctx, size_t b, size_t e) { (*static_cast<F*>(ctx))(b, e); };
+        range.count = count;
+        range.grain = grain;
+        runRange(&range, 0, chunks);
+        wait(range.counter);
+    }
 
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+    ~JobSystem() { stop(); }
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
+    static int selfTest();
+    static void benchmark(int maxThreads);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, inds.size() * sizeof(GLuint), inds.data(), GL_STATIC_DRAW);
+private:
+    struct Worker {
+        JobDeque deque;
+        Job jobs[JOB_RING];
+        uint32_t nextJob = 0, rng = 1;
+        Worker() { for (Job& j : jobs) j.busy.store(false, std::memory_order_relaxed); }
+    };
 
-        // Pozisyon (2) + Doku koordinatları (2)
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
-        glEnableVertexAttribArray(1);
+    struct Range {
+        void* body;
+        void (*call)(void*, size_t, size_t);
+        size_t count, grain;
+        JobCounter counter;
+    };
 
-        glBindVertexArray(0);
+    vector<std::unique_ptr<Worker>> slots;
+    vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint64_t epoch = 0;
+    std::atomic<int> sleeping{ 0 };
+    std::atomic<bool> quit{ false };
+
+    static int& threadIndex() {
+        thread_local int index = -1;
+        return index;
     }
 
-    // Parametreli constructor (zemin için, 3D vertex'ler)
-    TextureMesh(const vector<GLfloat>& vertices, const vector<GLuint>& indices) : verts(vertices), inds(indices) {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+    // Parça aralığı [c0, c1): sağ yarı kuyruğa, sol yarıyla devam; tek parça kalınca gövde
+    static void runRange(void* ctx, size_t c0, size_t c1) {
+        Range& r = *static_cast<Range*>(ctx);
+        while (c1 - c0 > 1) {
+            size_t mid = c0 + (c1 - c0) / 2;
+            current().spawn(&JobSystem::runRange, ctx, mid, c1, &r.counter);
+            c1 = mid;
+        }
+        r.call(r.body, c0 * r.grain, std::min((c0 + 1) * r.grain, r.count));
+    }
 
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
+    // Halka sırayla dolaşılır; hâlâ kuyrukta olan yuva atlanır, hepsi doluysa çağıran işi kendisi çalıştırır
+    static Job* allocate(Worker& w) {
+        for (int i = 0; i < JOB_RING; ++i) {
+            Job& job = w.jobs[w.nextJob++ & (JOB_RING - 1)];
+            if (!job.busy.load(std::memory_order_acquire)) {
+                job.busy.store(true, std::memory_order_relaxed);
+                return &job;
+            }
+        }
+        return nullptr;
+    }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, inds.size() * sizeof(GLuint), inds.data(), GL_STATIC_DRAW);
+    static void execute(Job* job) {
+        void (*fn)(void*, size_t, size_t) = job->fn;
+        void* ctx = job->ctx;
+        size_t a = job->a, b = job->b;
+        JobCounter* counter = job->counter;
+        job->busy.store(false, std::memory_order_release);
+        fn(ctx, a, b);
+        if (counter) counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
 
-        // Pozisyon (3) + Doku koordinatları (2)
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-        glEnableVertexAttribArray(1);
+    Job* find(int self) {
+        Worker& me = *slots[self];
+        if (Job* job = me.deque.pop()) return job;
+        uint32_t n = static_cast<uint32_t>(slots.size());
+        me.rng ^= me.rng << 13; me.rng ^= me.rng >> 17; me.rng ^= me.rng << 5;
+        for (uint32_t i = 0, start = me.rng % n; i < n; ++i) {
+            uint32_t victim = (start + i) % n;
+            if (victim == static_cast<uint32_t>(self)) continue;
+            if (Job* job = slots[victim]->deque.steal()) return job;
+        }
+        return nullptr;
+    }
 
-        glBindVertexArray(0);
+    bool anyWork() const {
+        for (const std::unique_ptr<Worker>& w : slots) if (!w->deque.empty()) return true;
+        return false;
     }
 
-    void draw() const {
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, inds.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    void loop(int index) {
+        threadIndex() = index;
+        TRACE_THREAD("worker");
+        int idle = 0;
+        while (!quit.load(std::memory_order_acquire)) {
+            if (Job* job = find(index)) {
+                execute(job);
+                idle = 0;
+                continue;
+            }
+            if (++idle < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            // Uyumadan önce uyuyan sayısı artırılıp kuyruklara yeniden bakılır: spawn ya işi görünür kılar ya da uyandırır
+            std::unique_lock<std::mutex> lock(mutex);
+            sleeping.fetch_add(1, std::memory_order_seq_cst);
+            uint64_t seen = epoch;
+            if (!anyWork()) wake.wait(lock, [&] { return quit.load(std::memory_order_relaxed) || epoch != seen; });
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+            idle = 0;
+        }
     }
 
-    ~TextureMesh() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit.store(true, std::memory_order_release);
+            ++epoch;
+        }
+        wake.notify_all();
+        for (std::thread& t : threads) t.join();
+        threads.clear();
+        slots.clear();
     }
 };
 
-class Texture {
+// Görev çizgesi: düğüm, bağımlı olduğu düğümlerin hepsi bitince iş sistemine verilir; run() çizge bitene kadar
+// çağıranı da çalıştırır. Düğümler içeride parallelFor açabilir. Sabit diziler: her kare yeniden kurmak ayırmasız.
+class TaskGraph {
 public:
-    GLuint ID;
-    int width, height;
-
-    Texture(const char* path) {
-        glGenTextures(1, &ID);
-        bind();
+    enum { MAX_TASKS = 32, MAX_DEPENDENTS = 8 };
+
+    TaskGraph() : count(0) {}
+
+    void clear() { count = 0; }
+
+    // fn run() bitene kadar yaşamalı. Çizge doluysa -1 döner; çağıran işi kendisi koşturmalı
+    template<typename F>
+    int add(const char* name, F& fn) {
+        if (count >= MAX_TASKS) return -1;
+        Task& t = tasks[count];
+        t.name = name;
+        t.ctx = &fn;
+        t.call = [](void* ctx) { (*static_cast<F*>(ctx))(); };
+        t.deps = t.dependentCount = 0;
+        return count++;
+    }
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // task, on bitmeden başlamaz. Geçersiz indeks (add'in -1'i dahil), dolu bağımlı listesi, kendine ya da döngü kuran
+    // bağımlılık reddedilir (false) ve çizge değişmez: run() hiç bitmezdi ya da diziler taşardı
+    bool depend(int task, int on) {
+        if (task < 0 || task >= count || on < 0 || on >= count || task == on) return false;
+        if (tasks[on].dependentCount >= MAX_DEPENDENTS || reaches(task, on)) return false;
+        tasks[on].dependents[tasks[on].dependentCount++] = task;
+        tasks[task].deps++;
+        return true;
+    }
 
-        stbi_set_flip_vertically_on_load(true);
-        unsigned char* data = stbi_load(path, &width, &height, nullptr, 4);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-        }
-        else {
-            std::cerr << "Failed to load texture: " << path << std::endl;
-            unsigned char white[] = { 255, 255, 255, 255 };
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
-            width = height = 1;
-        }
-        stbi_image_free(data);
+    void run() {
+        for (int i = 0; i < count; ++i) tasks[i].remaining.store(tasks[i].deps, std::memory_order_relaxed);
+        for (int i = 0; i < count; ++i) if (tasks[i].deps == 0) JobSystem::current().spawn(&TaskGraph::runTask, this, static_cast<size_t>(i), 0, &counter);
+        JobSystem::current().wait(counter);
     }
 
-    void bind(GLenum textureUnit = GL_TEXTURE0) const {
-        glActiveTexture(textureUnit);
-        glBindTexture(GL_TEXTURE_2D, ID);
+private:
+    struct Task {
+        const char* name;
+        void* ctx;
+        void (*call)(void*);
+        int deps, dependentCount;
+        int dependents[MAX_DEPENDENTS];
+        std::atomic<int> remaining;
+    };
+    Task tasks[MAX_TASKS];
+    int count;
+    JobCounter counter;
+
+    // from'dan bağımlılar boyunca to'ya varılıyor mu (to, from'u zaten bekliyor mu)
+    bool reaches(int from, int to) const {
+        static_assert(MAX_TASKS <= 32, "visited mask is 32 bits");
+        int stack[MAX_TASKS], top = 0;
+        uint32_t visited = 1u << from;
+        stack[top++] = from;
+        while (top) {
+            const Task& t = tasks[stack[--top]];
+            for (int i = 0; i < t.dependentCount; ++i) {
+                int d = t.dependents[i];
+                if (d == to) return true;
+                if (visited & (1u << d)) continue;
+                visited |= 1u << d;
+                stack[top++] = d;
+            }
+        }
+        return false;
     }
 
-    ~Texture() {
-        glDeleteTextures(1, &ID);
+    // Bağımlılar bu görevin sayaç düşüşünden önce verilir: çizge sayacı erken sıfırlanmaz
+    static void runTask(void* ctx, size_t index, size_t) {
+        TaskGraph& g = *static_cast<TaskGraph*>(ctx);
+        Task& t = g.tasks[index];
+        {
+            TRACE_SCOPE(t.name);
+            t.call(t.ctx);
+        }
+        for (int i = 0; i < t.dependentCount; ++i) {
+            int d = t.dependents[i];
+            if (g.tasks[d].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                JobSystem::current().spawn(&TaskGraph::runTask, ctx, static_cast<size_t>(d), 0, &g.counter);
+        }
     }
 };
 
-class Renderer {
-public:
-    void draw(const Mesh& mesh, Shader& shader, const glm::mat4& view, const glm::mat4& proj, const glm::mat4& model, const glm::vec4& color) {
-        shader.use();
-        shader.setMat4("model", model);
-        shader.setMat4("view", view);
-        shader.setMat4("projection", proj);
-        shader.setVec4("color", color);
+// --jobs-test: kuyruk ve zamanlayıcı yoğun yarışta denetlenir; her iş tam bir kez alınmalı, sayaçlar ve çizge sırası
+// tutmalı. Başarısız denetim sayısını döner.
+int JobSystem::selfTest() {
+    int failures = 0;
+    auto check = [&](bool ok, const std::string& what) {
+        cout << (ok ? "  ok    " : "  FAIL  ") << what << endl;
+        if (!ok) failures++;
+    };
+    int hw = glm::max(static_cast<int>(std::thread::hardware_concurrency()), 2);
+    vector<Job> items(1 << 18);
+
+    // Tek iş parçacığı: kapasite sınırı, sahip LIFO, hırsız FIFO
+    {
+        std::unique_ptr<JobDeque> q(new JobDeque);
+        int pushed = 0;
+        while (q->push(&items[pushed])) pushed++;
+        bool order = q->pop() == &items[JobDeque::CAPACITY - 1] && q->steal() == &items[0];
+        int drained = 2;
+        while (q->pop()) drained++;
+        check(pushed == JobDeque::CAPACITY && order && drained == JobDeque::CAPACITY && !q->steal() && q->empty(), "deque capacity, LIFO pop, FIFO steal");
+    }
 
-        glBindVertexArray(mesh.VAO);
-        glDrawElements(GL_TRIANGLES, mesh.inds.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    // Sahip itip çekerken hırsızlar çalar: her eleman tam bir kez alınmalı. İkinci turda kuyruk hep 0-1 eleman
+    // tutar, son eleman için pop/steal CAS yarışı sürekli tetiklenir.
+    for (int round = 0; round < 2; ++round) {
+        std::unique_ptr<JobDeque> q(new JobDeque);
+        vector<std::atomic<uint8_t>> taken(items.size());
+        for (std::atomic<uint8_t>& t : taken) t.store(0, std::memory_order_relaxed);
+        std::atomic<bool> done(false);
+        std::atomic<size_t> stolen(0);
+        auto take = [&](Job* job) { taken[job - items.data()].fetch_add(1, std::memory_order_relaxed); };
+        vector<std::thread> thieves;
+        for (int t = 0; t < glm::max(hw * 2, 4); ++t) thieves.emplace_back([&] {
+            size_t mine = 0;
+            while (!done.load(std::memory_order_acquire) || !q->empty())
+                if (Job* job = q->steal()) { take(job); mine++; }
+            stolen.fetch_add(mine, std::memory_order_relaxed);
+            });
+        uint32_t rng = 12345;
+        for (size_t i = 0; i < items.size();) {
+            rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+            size_t burst = round == 0 ? 1 + rng % 64 : 1;
+            for (size_t k = 0; k < burst && i < items.size(); ++k, ++i) while (!q->push(&items[i])) if (Job* job = q->pop()) take(job);
+            if ((i & 255) == 0) std::this_thread::yield(); // Tek çekirdekte de hırsızlar dolu kuyruğa denk gelsin
+            size_t pops = round == 0 ? rng % 48 : 1;
+            for (size_t k = 0; k < pops; ++k) if (Job* job = q->pop()) take(job);
+        }
+        while (Job* job = q->pop()) take(job);
+        done.store(true, std::memory_order_release);
+        for (std::thread& t : thieves) t.join();
+        bool once = true;
+        for (std::atomic<uint8_t>& t : taken) once = once && t.load(std::memory_order_relaxed) == 1;
+        check(once, std::string(round == 0 ? "burst push/pop" : "single-element pop/steal race") + " vs " + std::to_string(thieves.size()) +
+            " thieves: every job taken once (" + std::to_string(stolen.load()) + " stolen)");
     }
 
-    // Tek bir drawTexture fonksiyonu: hem 3D hem 2D için kullanılabilir
-    void drawTexture(const TextureMesh& mesh, Shader& shader, Texture& texture,
-        const glm::mat4& model, const glm::mat4& view, const glm::mat4& proj,
-        const glm::vec4& colorTint, bool is2D = false) {
-        shader.use();
-        shader.setMat4("model", model);
-        if (!is2D) {
-            shader.setMat4("view", view);
+    // Zamanlayıcı: farklı işçi sayılarında parça kapsaması, iç içe parallelFor, sayaç ve çizge bağımlılıkları
+    JobSystem& js = current();
+    int workerCounts[] = { 0, 1, 3, glm::max(7, hw * 2 - 1) };
+    for (int workers : workerCounts) {
+        js.start(workers);
+        const size_t n = 1000003;
+        vector<std::atomic<uint8_t>> hits(n);
+        bool covered = true;
+        size_t grains[] = { 1, 7, 1024 };
+        for (size_t grain : grains) {
+            for (std::atomic<uint8_t>& h : hits) h.store(0, std::memory_order_relaxed);
+            std::atomic<bool> aligned(true);
+            auto body = [&](size_t b, size_t e) {
+                if (b % grain != 0 || (e != n && e - b != grain)) aligned.store(false);
+                for (size_t i = b; i < e; ++i) hits[i].fetch_add(1, std::memory_order_relaxed);
+                };
+            js.parallelFor(n, grain, body);
+            for (std::atomic<uint8_t>& h : hits) covered = covered && h.load(std::memory_order_relaxed) == 1;
+            covered = covered && aligned.load();
         }
-        shader.setMat4("projection", proj);
-        shader.setVec4("colorTint", colorTint);
+        std::string threads = std::to_string(js.size()) + " threads: ";
+        check(covered, threads + "parallelFor covers every index once on grain boundaries");
+
+        std::atomic<size_t> inner(0);
+        auto outer = [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                auto body = [&](size_t ib, size_t ie) { inner.fetch_add(ie - ib, std::memory_order_relaxed); };
+                js.parallelFor(1000, 10, body);
+            }
+            };
+        js.parallelFor(64, 1, outer);
+        check(inner.load() == 64000, threads + "nested parallelFor");
+
+        JobCounter counter;
+        std::atomic<int> ran(0);
+        struct Ctx { std::atomic<int>* ran; };
+        Ctx ctx = { &ran };
+        for (int i = 0; i < 20000; ++i)
+            js.spawn([](void* c, size_t, size_t) { static_cast<Ctx*>(c)->ran->fetch_add(1, std::memory_order_relaxed); }, &ctx, 0, 0, &counter);
+        js.wait(counter);
+        check(ran.load() == 20000 && counter.pending.load() == 0, threads + "20000 spawned jobs on one counter");
+
+        // Elmas çizgeler: a -> (b, c) -> d, yüz kez; her görev sırasını damgalar
+        bool ordered = true;
+        for (int rep = 0; rep < 100; ++rep) {
+            std::atomic<int> clock(0);
+            int at[4];
+            auto a = [&] { at[0] = clock.fetch_add(1); };
+            auto b = [&] { at[1] = clock.fetch_add(1); };
+            auto c = [&] { auto body = [&](size_t, size_t) {}; js.parallelFor(100, 1, body); at[2] = clock.fetch_add(1); };
+            auto d = [&] { at[3] = clock.fetch_add(1); };
+            TaskGraph g;
+            int ta = g.add("a", a), tb = g.add("b", b), tc = g.add("c", c), td = g.add("d", d);
+            bool built = g.depend(tb, ta) && g.depend(tc, ta) && g.depend(td, tb) && g.depend(td, tc);
+            g.run();
+            ordered = ordered && built && clock.load() == 4 && at[0] < at[1] && at[0] < at[2] && at[1] < at[3] && at[2] < at[3];
+        }
+        check(ordered, threads + "task graph runs dependencies first");
+    }
+    {
+        // Döngü ve kendine bağımlılık reddedilir; çizge yine de biter
+        int ran = 0;
+        auto f = [&] { ran++; };
+        TaskGraph g;
+        int ta = g.add("a", f), tb = g.add("b", f), tc = g.add("c", f);
+        bool chain = g.depend(tb, ta) && g.depend(tc, tb);
+        bool rejected = !g.depend(ta, ta) && !g.depend(ta, tc) && !g.depend(ta, tb);
+        g.run();
+        check(chain && rejected && ran == 3, "task graph rejects cycles and self-dependencies");
+    }
+    {
+        // Kapasite aşımı sürümde de reddedilir: 33. görev -1, 9. bağımlı ve geçersiz indeks false
+        auto f = [] {};
+        TaskGraph g;
+        int added = 0;
+        for (int i = 0; i < TaskGraph::MAX_TASKS; ++i) added += g.add("t", f) == i;
+        bool full = g.add("extra", f) == -1;
+        int accepted = 0;
+        for (int i = 1; i <= TaskGraph::MAX_DEPENDENTS + 1; ++i) accepted += g.depend(i, 0);
+        bool invalid = !g.depend(-1, 0) && !g.depend(0, -1) && !g.depend(TaskGraph::MAX_TASKS, 0);
+        g.run();
+        check(added == TaskGraph::MAX_TASKS && full && accepted == TaskGraph::MAX_DEPENDENTS && invalid, "task graph rejects overflow and bad indices");
+    }
+    js.start(0);
+    if (failures) cout << "Job system self-test: " << failures << " FAILED" << endl;
+    else cout << "Job system self-test passed" << endl;
+    return failures;
+}
+
+// --jobs-bench: 1'den maxThreads'e iş parçacığı sayısında aynı iş yükleri; hızlanma 1 iş parçacığına göre
+void JobSystem::benchmark(int maxThreads) {
+    JobSystem& js = current();
+    const size_t n = 1 << 20;
+    vector<float> out(n);
+    auto compute = [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            float x = static_cast<float>(i) * 1e-6f;
+            for (int k = 0; k < 16; ++k) x = x * 0.999f + sin(x);
+            out[i] = x;
+        }
+        };
+    auto time = [](auto&& fn, int reps) {
+        double best = 1e30;
+        for (int r = 0; r < reps; ++r) {
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        }
+        return best;
+    };
+    cout << "threads  parallelFor ms  speedup  efficiency  spawn ns/job  graph ms" << endl;
+    double base = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads = threads < maxThreads && threads * 2 > maxThreads ? maxThreads : threads * 2) {
+        js.start(threads - 1);
+        double forMs = time([&] { js.parallelFor(n, 1024, compute); }, 5);
+        if (threads == 1) base = forMs;
+
+        const int jobs = 100000;
+        JobCounter counter;
+        double spawnMs = time([&] {
+            for (int i = 0; i < jobs; ++i) js.spawn([](void*, size_t, size_t) {}, nullptr, 0, 0, &counter);
+            js.wait(counter);
+            }, 5);
+
+        // Kare benzeri çizge: 4 paralel zincir (her aşama bir parallelFor), sonda birleşme
+        auto stage = [&] { js.parallelFor(n / 8, 1024, compute); };
+        double graphMs = time([&] {
+            TaskGraph g;
+            int last[4];
+            bool built = true;
+            for (int c = 0; c < 4; ++c) for (int s = 0; s < 3; ++s) {
+                int t = g.add("stage", stage);
+                built = built && t >= 0 && (s == 0 || g.depend(t, last[c]));
+                last[c] = t;
+            }
+            int join = g.add("join", stage);
+            built = built && join >= 0;
+            for (int c = 0; c < 4; ++c) built = built && g.depend(join, last[c]);
+            if (built) g.run();
+            else for (int i = 0; i < 13; ++i) stage(); // Çizge kurulamadıysa aynı iş sırayla
+            }, 5);
+        printf("%7d  %14.2f  %7.2fx  %9.0f%%  %12.1f  %8.2f\n", threads, forMs, base / forMs, base / forMs / threads * 100.0, spawnMs * 1e6 / jobs, graphMs);
+    }
+    js.start(0);
+}
 
-        texture.bind(GL_TEXTURE0); // Artık parametre kabul ediyor
-        glUniform1i(glGetUniformLocation(shader.ID, "texture1"), 0);
+// Salt okunur dosya eşlemesi: içerik kopyalanmadan doğrudan işletim sisteminin sayfa önbelleğinden okunur
+class MappedFile {
+public:
+    const unsigned char* data;
+    size_t size;
 
-        if (is2D) {
-            glDisable(GL_DEPTH_TEST);
-        }
-        mesh.draw();
-        if (is2D) {
-            glEnable(GL_DEPTH_TEST);
+    MappedFile() : data(nullptr), size(0) {
+#ifdef _WIN32
+        file = mapping = nullptr;
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) { file = nullptr; return false; }
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(file, &length) || length.QuadPart == 0) { close(); return false; }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) { close(); return false; }
+        data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        size = data ? static_cast<size_t>(length.QuadPart) : 0;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) { data = static_cast<const unsigned char*>(p); size = static_cast<size_t>(st.st_size); }
         }
+        ::close(fd); // Eşleme dosya tanıtıcısından bağımsız yaşar
+#endif
+        if (!data) close();
+        return data != nullptr;
     }
+
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file) CloseHandle(file);
+        file = mapping = nullptr;
+#else
+        if (data) munmap(const_cast<unsigned char*>(data), size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    ~MappedFile() { close(); }
+
+private:
+#ifdef _WIN32
+    HANDLE file, mapping;
+#endif
 };
 
-class TextRenderer {
+// FNV-1a 64
+static uint64_t fnv1a(const char* data, size_t size, uint64_t h = 1469598103934665603ull) {
+    for (size_t i = 0; i < size; ++i) { h ^= static_cast<unsigned char>(data[i]); h *= 1099511628211ull; }
+    return h;
+}
+
+// assets.pak: --pack'in assets.manifest'ten ürettiği tek arşiv. Başlık, ad özetine göre sıralı içindekiler tablosu
+// ve manifest (yükleme) sırasında, 64 bayt hizalı veriler. Açılışta bir kez eşlenir; Texture, TextRenderer, Shader ve
+// ArenaMap kopyasız görünüm alır. Pakette olmayan varlıklar eskisi gibi gevşek dosyalardan okunur.
+struct PackHeader {
+    char magic[4];              // "CPAK"
+    uint32_t version, count, reserved;
+};
+
+struct PackEntry {
+    uint64_t hash, offset, size;
+    uint32_t format, width, height, reserved;
+};
+
+class AssetPack {
 public:
-    struct Char {
-        GLuint texID;
-        glm::ivec2 size;
-        glm::ivec2 bearing;
-        GLuint advance;
+    enum Format { RAW = 0, RGBA8 = 1, IMAGE = 2 }; // RGBA8: çözülmüş, dikey çevrilmiş pikseller; IMAGE: PNG baytları
+    enum { VERSION = 1, ALIGN = 64 };
+
+    struct View {
+        const unsigned char* data;
+        size_t size;
+        uint32_t format, width, height;
     };
 
-    map<char, Char> chars;
-    Shader* shader;
-    GLuint VAO, VBO;
+    MappedFile file;
+    const PackEntry* entries;
+    uint32_t count;
 
-    TextRenderer(Shader* s) : shader(s) {
-        FT_Library ft;
-        FT_Init_FreeType(&ft);
+    AssetPack() : entries(nullptr), count(0) {}
 
-        FT_Face face;
-        FT_New_Face(ft, "C:\\Windows\\Fonts\\arial.ttf", 0, &face);
-        FT_Set_Pixel_Sizes(face, 0, 48);
+    static AssetPack& current() { static AssetPack pack; return pack; }
+
+    bool open(const char* path) {
+        entries = nullptr;
+        count = 0;
+        if (!file.open(path)) return false;
+        const PackHeader* h = reinterpret_cast<const PackHeader*>(file.data);
+        if (file.size < sizeof(PackHeader) || memcmp(h->magic, "CPAK", 4) != 0 || h->version != VERSION ||
+            file.size < sizeof(PackHeader) + h->count * sizeof(PackEntry)) {
+            std::cerr << path << ": not a valid asset pack" << std::endl;
+            file.close();
+            return false;
+        }
+        entries = reinterpret_cast<const PackEntry*>(file.data + sizeof(PackHeader));
+        count = h->count;
+        return true;
+    }
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // Windows dosya sistemi gibi: büyük/küçük harf ve ayraç farkı yok sayılır
+    static uint64_t key(const char* name) {
+        uint64_t h = 1469598103934665603ull;
+        for (const char* p = name; *p; ++p) {
+            char c = *p == '\\' ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(*p)));
+            h = fnv1a(&c, 1, h);
+        }
+        return h;
+    }
 
-        for (GLubyte c = 0; c < 128; c++) {
-            FT_Load_Char(face, c, FT_LOAD_RENDER);
+    // İçindekiler tablosunda ikili arama; ad, gevşek dosyanın göreli yolu ("textures/Win1.png")
+    bool find(const char* name, View& view) const {
+        uint64_t key = AssetPack::key(name);
+        const PackEntry* end = entries + count;
+        const PackEntry* e = std::lower_bound(entries, end, key, [](const PackEntry& a, uint64_t k) { return a.hash < k; });
+        if (e == end || e->hash != key || e->offset + e->size > file.size) return false;
+        view.data = file.data + e->offset;
+        view.size = static_cast<size_t>(e->size);
+        view.format = e->format;
+        view.width = e->width;
+        view.height = e->height;
+        return true;
+    }
 
-            GLuint tex;
-            glGenTextures(1, &tex);
-            glBindTexture(GL_TEXTURE_2D, tex);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, face->glyph->bitmap.width, face->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
+    // Önce paket, yoksa gevşek dosya; storage yalnızca dosyadan okunduğunda dolar ve görünüm ona işaret eder
+    static bool load(const string& name, View& view, string& storage) {
+        if (current().find(name.c_str(), view)) return true;
+        if (!readFile(name, storage)) return false;
+        view.data = reinterpret_cast<const unsigned char*>(storage.data());
+        view.size = storage.size();
+        view.format = RAW;
+        view.width = view.height = 0;
+        return true;
+    }
 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    static bool readFile(const string& path, string& out) {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return false;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        out.resize(size > 0 ? size : 0);
+        size_t got = size > 0 ? fread(&out[0], 1, size, f) : 0;
+        fclose(f);
+        return got == out.size();
+    }
 
-            Char ch = { tex, glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                        glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                        static_cast<GLuint>(face->glyph->advance.x) };
-            chars[c] = ch;
+    // Paketleyici: manifestte satır başına bir göreli yol (# yorum). Görüntüler varsayılan olarak çözülüp RGBA8
+    // saklanır (açılışta çözme yok); compressed ile PNG baytları olduğu gibi kalır
+    static int build(const char* manifestPath, const char* outPath, bool compressed) {
+        string manifest;
+        if (!readFile(manifestPath, manifest)) { std::cerr << "Cannot read " << manifestPath << std::endl; return 1; }
+        std::istringstream lines(manifest);
+        vector<string> names;
+        string line;
+        while (std::getline(lines, line)) {
+            line = line.substr(0, line.find('#'));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            line.erase(0, line.find_first_not_of(" \t"));
+            if (!line.empty()) names.push_back(line);
         }
-        glBindTexture(GL_TEXTURE_2D, 0);
 
-        FT_Done_Face(face);
-        FT_Done_FreeType(ft);
+        vector<PackEntry> toc(names.size());
+        vector<unsigned char> data;
+        uint64_t base = sizeof(PackHeader) + names.size() * sizeof(PackEntry);
+        base = (base + ALIGN - 1) / ALIGN * ALIGN;
+        for (size_t i = 0; i < names.size(); ++i) {
+            PackEntry& e = toc[i];
+            memset(&e, 0, sizeof(e));
+            e.hash = key(names[i].c_str());
+            for (size_t j = 0; j < i; ++j)
+                if (toc[j].hash == e.hash) { std::cerr << "Hash collision: " << names[i] << " / " << names[j] << std::endl; return 1; }
+            string bytes;
+            if (!readFile(names[i], bytes)) { std::cerr << "Cannot read " << names[i] << std::endl; return 1; }
+            data.resize((data.size() + ALIGN - 1) / ALIGN * ALIGN);
+            e.offset = base + data.size();
+            string ext = names[i].substr(names[i].find_last_of('.') + 1);
+            bool image = ext == "png" || ext == "jpg" || ext == "tga" || ext == "bmp";
+            int w = 0, h = 0;
+            stbi_set_flip_vertically_on_load(true);
+            unsigned char* pixels = image && !compressed ?
+                stbi_load_from_memory(reinterpret_cast<const unsigned char*>(bytes.data()), static_cast<int>(bytes.size()), &w, &h, nullptr, 4) : nullptr;
+            if (pixels) {
+                e.format = RGBA8; e.width = w; e.height = h; e.size = static_cast<uint64_t>(w) * h * 4;
+                data.insert(data.end(), pixels, pixels + e.size);
+                stbi_image_free(pixels);
+            }
+            else {
+                e.format = image ? IMAGE : RAW; e.size = bytes.size();
+                data.insert(data.end(), bytes.begin(), bytes.end());
+            }
+        }
+        std::sort(toc.begin(), toc.end(), [](const PackEntry& a, const PackEntry& b) { return a.hash < b.hash; });
+
+        PackHeader header;
+        memcpy(header.magic, "CPAK", 4);
+        header.version = VERSION;
+        header.count = static_cast<uint32_t>(toc.size());
+        header.reserved = 0;
+        FILE* f = fopen(outPath, "wb");
+        if (!f) { std::cerr << "Cannot write " << outPath << std::endl; return 1; }
+        fwrite(&header, sizeof(header), 1, f);
+        fwrite(toc.data(), sizeof(PackEntry), toc.size(), f);
+        vector<unsigned char> padding(static_cast<size_t>(base - sizeof(PackHeader) - toc.size() * sizeof(PackEntry)), 0);
+        fwrite(padding.data(), 1, padding.size(), f);
+        fwrite(data.data(), 1, data.size(), f);
+        fclose(f);
+        std::cout << "Packed " << toc.size() << " assets into " << outPath << " (" << (base + data.size()) / 1024 << " KB)" << std::endl;
+        return 0;
+    }
+};
 
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
-        glBindVertexArray(0);
+// Görüntü kalitesinin tüm düğmeleri tek yerde: mesh çözünürlüğü, kalabalık, doku boyutu ve mip sapması, 3B ölçek,
+// uzak düzlem. Dört hazır ayar ya da CUSTOM (settings.cfg'deki değerler aynen kullanılır).
+struct QualitySettings {
+    enum Preset { LOW, MEDIUM, HIGH, ULTRA, CUSTOM };
+    Preset preset;
+    int circleSegments;  // Dalga halkasının çevresi; sütunlar bunun 3/8'i
+    int spectators;
+    int maxTextureSize;  // Daha büyük dokular yüklenirken yarıya indirilir
+    float mipBias;       // GL_TEXTURE_LOD_BIAS: pozitif daha bulanık ama daha az bant genişliği
+    float renderScale;   // Dinamik çözünürlüğün üst sınırı
+    float farPlane;
+
+    static QualitySettings make(Preset p) {
+        static const QualitySettings table[] = {
+            { LOW, 24, 40, 1024, 0.5f, 0.6f, 60.0f },
+            { MEDIUM, 40, 45, 2048, 0.25f, 0.8f, 80.0f },
+            { HIGH, 64, 50, 4096, 0.0f, 1.0f, 100.0f },
+            { ULTRA, 96, 150, 8192, -0.25f, 1.0f, 120.0f },
+        };
+        return table[p == CUSTOM ? HIGH : p];
     }
 
-    void draw(string text, float x, float y, float scale, glm::vec3 color) {
-        shader->use();
-        glUniform3f(glGetUniformLocation(shader->ID, "textColor"), color.x, color.y, color.z);
-        glActiveTexture(GL_TEXTURE0);
-        glBindVertexArray(VAO);
+    static const char* name(Preset p) {
+        static const char* names[] = { "low", "medium", "high", "ultra", "custom" };
+        return names[p];
+    }
 
-        for (char c : text) {
-            Char ch = chars[c];
+    static bool parse(const char* text, Preset& out) {
+        for (int p = LOW; p <= CUSTOM; ++p) if (strcmp(text, name(static_cast<Preset>(p))) == 0) { out = static_cast<Preset>(p); return true; }
+        return false;
+    }
 
-            GLfloat xpos = x + ch.bearing.x * scale;
-            GLfloat ypos = y - (ch.size.y - ch.bearing.y) * scale;
+    int pillarSegments() const { return glm::max(circleSegments * 3 / 8, 8); }
+};
 
-            GLfloat w = ch.size.x * scale;
-            GLfloat h = ch.size.y * scale;
+// settings.cfg: "anahtar değer" satırları. Yoksa ilk açılışta kalite kıyaslaması çalışır ve dosya yazılır
+struct Settings {
+    float mouseSensitivity;
+    QualitySettings quality;
+    QualitySettings custom; // Hazır ayar seçiliyken de CUSTOM değerleri korunur (Q ile geri dönülür)
 
-            GLfloat vertices[6][4] = {
-                { xpos,     ypos + h,   0.0f, 0.0f },
-                { xpos,     ypos,       0.0f, 1.0f },
-                { xpos + w, ypos,       1.0f, 1.0f },
-                { xpos,     ypos + h,   0.0f, 0.0f },
-                { xpos + w, ypos,       1.0f, 1.0f },
-                { xpos + w, ypos + h,   1.0f, 0.0f }
-            };
+    static Settings& current() {
+        static Settings settings = { 0.5f, QualitySettings::make(QualitySettings::HIGH), QualitySettings::make(QualitySettings::HIGH) };
+        return settings;
+    }
 
-            glBindTexture(GL_TEXTURE_2D, ch.texID);
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            x += (ch.advance >> 6) * scale;
+    bool load(const char* path = "settings.cfg") {
+        FILE* f = fopen(path, "r");
+        if (!f) return false;
+        char key[64], value[64];
+        QualitySettings::Preset preset = quality.preset;
+        while (fscanf(f, "%63s %63s", key, value) == 2) {
+            if (!strcmp(key, "mouseSensitivity")) mouseSensitivity = glm::clamp(static_cast<float>(atof(value)), 0.1f, 1.0f);
+            else if (!strcmp(key, "quality")) QualitySettings::parse(value, preset);
+            else if (!strcmp(key, "circleSegments")) custom.circleSegments = glm::clamp(atoi(value), 8, 256);
+            else if (!strcmp(key, "spectators")) custom.spectators = glm::max(atoi(value), 0);
+            else if (!strcmp(key, "maxTextureSize")) custom.maxTextureSize = glm::max(atoi(value), 16);
+            else if (!strcmp(key, "mipBias")) custom.mipBias = static_cast<float>(atof(value));
+            else if (!strcmp(key, "renderScale")) custom.renderScale = glm::clamp(static_cast<float>(atof(value)), 0.25f, 1.0f);
+            else if (!strcmp(key, "farPlane")) custom.farPlane = glm::max(static_cast<float>(atof(value)), 10.0f);
         }
-        glBindVertexArray(0);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        fclose(f);
+        custom.preset = QualitySettings::CUSTOM;
+        quality = preset == QualitySettings::CUSTOM ? custom : QualitySettings::make(preset);
+        return true;
     }
 
-    ~TextRenderer() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        for (auto& pair : chars) glDeleteTextures(1, &pair.second.texID);
+    // Düğmeler her zaman CUSTOM değerleridir (hazır ayar seçiliyken kaybolmasınlar); kullanıcı birini elle değiştirip
+    // quality'yi custom yapabilir
+    void save(const char* path = "settings.cfg") const {
+        FILE* f = fopen(path, "w");
+        if (!f) return;
+        const QualitySettings& knobs = quality.preset == QualitySettings::CUSTOM ? quality : custom;
+        fprintf(f, "mouseSensitivity %.3f\nquality %s\ncircleSegments %d\nspectators %d\nmaxTextureSize %d\nmipBias %.2f\nrenderScale %.2f\nfarPlane %.0f\n",
+            mouseSensitivity, QualitySettings::name(quality.preset), knobs.circleSegments, knobs.spectators, knobs.maxTextureSize,
+            knobs.mipBias, knobs.renderScale, knobs.farPlane);
+        fclose(f);
     }
 };
 
-class Player {
+class Window {
 public:
-    glm::vec3 pos, rollDir, lastValidRollDir;
-    float speed = 3.0f, rollTime, jumpVel, dashTime, dashCool, superJumpCool, lastMoveTime;
-    bool rolling, jumping, dashing, waveTriggered, superJumpUsed, isMoving, enableAbilities;
-    const float rollDur = 1.0f, gravity = 9.8f, jumpPower = 4.0f, superJumpPower = 10.0f, dashDur = 0.2, dashSpeed = 12.0f, maxDashCool = 8.0f, maxSuperJumpCool = 15.0f, stopRollDur = 0.2f;
+    GLFWwindow* window;
+    int w, h;
+    GLuint target, targetColor, targetDepth; // Ekransız modda karelerin çizildiği FBO; 0 = pencerenin kendisi
 
-    Player(glm::vec3 startPos = glm::vec3(0.0f), bool enableAbilities = true) : pos(startPos), rolling(false), rollTime(0.0f),
-        jumping(false), jumpVel(0.0f), dashing(false), dashTime(0.0f), dashCool(0.0f), superJumpCool(0.0f),
-        waveTriggered(false), superJumpUsed(false), isMoving(false), lastMoveTime(0.0f), enableAbilities(enableAbilities) {
+    // --headless: pencere gizli açılır (yalnızca GL bağlamı için), kareler pencere boyutunda bir FBO'ya çizilir
+    static bool& offscreen() {
+        static bool value = false;
+        return value;
     }
 
-    void update(Window& win, Camera& cam, float dt) {
-        glm::vec3 dir(0.0f);
-        bool movingNow = false;
+    Window(int width, int height, const char* title) : w(width), h(height), target(0), targetColor(0), targetDepth(0) {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        if (offscreen()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
-        if (glfwGetKey(win.window, GLFW_KEY_W) == GLFW_PRESS) { dir += cam.front; movingNow = true; }
-        if (glfwGetKey(win.window, GLFW_KEY_S) == GLFW_PRESS) { dir -= cam.front; movingNow = true; }
-        if (glfwGetKey(win.window, GLFW_KEY_A) == GLFW_PRESS) { dir += cam.getRight(); movingNow = true; }
-        if (glfwGetKey(win.window, GLFW_KEY_D) == GLFW_PRESS) { dir -= cam.getRight(); movingNow = true; }
+        window = glfwCreateWindow(w, h, title, NULL, NULL); glfwMakeContextCurrent(window); glewInit();
 
-        if (movingNow != isMoving) {
-            isMoving = movingNow;
-            if (isMoving) {
-                rolling = true;
-                rollTime = 0.0f;
-                dir.y = 0.0f;
-                if (glm::length(dir) > 0.001f) {
-                    rollDir = glm::normalize(dir);
-                }
+        if (offscreen()) {
+            glGenFramebuffers(1, &target);
+            glGenRenderbuffers(1, &targetColor);
+            glGenRenderbuffers(1, &targetDepth);
+            glBindRenderbuffer(GL_RENDERBUFFER, targetColor);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+            glBindRenderbuffer(GL_RENDERBUFFER, targetDepth);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+            glBindFramebuffer(GL_FRAMEBUFFER, target);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, targetColor);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, targetDepth);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) std::cerr << "Headless: framebuffer incomplete" << std::endl;
+        }
+
+        glViewport(0, 0, w, h); glEnable(GL_DEPTH_TEST); glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    }
+
+    bool shouldClose() { return glfwWindowShouldClose(window); }
+    void swap() {
+        TRACE_SCOPE("swap");
+        if (!target) glfwSwapBuffers(window);
+    }
+    void poll() {
+        TRACE_SCOPE("poll");
+        glfwPollEvents();
+    }
+    ~Window() {
+        if (target) {
+            glDeleteFramebuffers(1, &target);
+            glDeleteRenderbuffers(1, &targetColor);
+            glDeleteRenderbuffers(1, &targetDepth);
+        }
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+};
+
+// GLSL dosyalardan okunur (shaders/<ad>.vert/.frag). Bağlanmış programlar kaynak özeti ve sürücü kimliğiyle
+// anahtarlanarak shadercache/ altına ikili olarak yazılır; sonraki açılışlarda derleme atlanır.
+class Shader {
+public:
+    GLuint ID;
+    string name, vertexPath, fragmentPath;
+    vector<const char*> feedback; // Transform feedback çıktıları (bağlamadan önce bildirilir), boşsa yok
+    static int cacheHits, compiled;
+    static double buildSeconds;
+#ifndef NDEBUG
+    long long vertexTime, fragmentTime; // Sıcak yeniden yükleme için son değişiklik zamanları
+#endif
+
+    Shader(const char* shaderName, std::initializer_list<const char*> feedbackVaryings = {}) : ID(0), name(shaderName),
+        vertexPath(string("shaders/") + shaderName + ".vert"), fragmentPath(string("shaders/") + shaderName + ".frag"), feedback(feedbackVaryings) {
+        string vsFile, fsFile;
+        AssetPack::View vs, fs;
+        if (!AssetPack::load(vertexPath, vs, vsFile) || !AssetPack::load(fragmentPath, fs, fsFile))
+            std::cerr << "Shader " << name << ": cannot read " << vertexPath << " / " << fragmentPath << std::endl;
+        else {
+            double start = glfwGetTime();
+            ID = build(vs, fs);
+            buildSeconds += glfwGetTime() - start;
+        }
+#ifndef NDEBUG
+        vertexTime = modifiedTime(vertexPath);
+        fragmentTime = modifiedTime(fragmentPath);
+#endif
+    }
+
+#ifndef NDEBUG
+    // Dosyalar değiştiyse yeniden derler; hata olursa eski program kullanılmaya devam eder
+    bool reloadIfChanged() {
+        long long vt = modifiedTime(vertexPath), ft = modifiedTime(fragmentPath);
+        if (vt == vertexTime && ft == fragmentTime) return false;
+        vertexTime = vt; fragmentTime = ft;
+        string vsFile, fsFile;
+        if (!AssetPack::readFile(vertexPath, vsFile) || !AssetPack::readFile(fragmentPath, fsFile)) return false;
+        GLuint program = build(view(vsFile), view(fsFile));
+        if (!program) return false;
+        glDeleteProgram(ID);
+        ID = program;
+        std::cout << "Shader reloaded: " << name << std::endl;
+        return true;
+    }
+
+    static long long modifiedTime(const string& path) {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0 ? static_cast<long long>(st.st_mtime) : 0;
+    }
+#endif
+
+    static AssetPack::View view(const string& s) {
+        AssetPack::View v = { reinterpret_cast<const unsigned char*>(s.data()), s.size(), AssetPack::RAW, 0, 0 };
+        return v;
+    }
+
+    static bool binaryCacheSupported() {
+        static int supported = -1;
+        if (supported < 0) {
+            GLint formats = 0;
+            if (GLEW_ARB_get_program_binary) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            supported = formats > 0;
+            if (supported) {
+#ifdef _WIN32
+                _mkdir("shadercache");
+#else
+                mkdir("shadercache", 0755);
+#endif
             }
-            lastMoveTime = static_cast<float>(glfwGetTime());
         }
+        return supported == 1;
+    }
 
-        if (isMoving && (!dashing || !enableAbilities)) {
-            dir.y = 0.0f;
-            if (glm::length(dir) > 0.001f) {
-                dir = glm::normalize(dir);
-                float turnSpeed = 10.0f * dt;
-                rollDir = glm::mix(rollDir, dir, turnSpeed);
-                if (glm::length(rollDir) > 0.9f) {
-                    lastValidRollDir = rollDir;
-                }
-                glm::vec3 newPos = pos + dir * speed * dt;
-
-                const float radius = 10.0f; // Arena yarıçapı
-                const float wallThickness = 0.5f; // Duvar kalınlığı
-                float dist = glm::length(glm::vec2(newPos.x, newPos.z));
-                if (dist + 0.5f > radius - wallThickness) { // 0.5f küp yarıçapı
-                    // Duvara çarptı, pozisyonu sınırda tut
-                    float angle = atan2(newPos.z, newPos.x);
-                    newPos.x = (radius - wallThickness - 0.5f) * cos(angle);
-                    newPos.z = (radius - wallThickness - 0.5f) * sin(angle);
-                }
-                pos = newPos;
+    // Önbellekten yükler, yoksa derleyip bağlar ve önbelleğe yazar. Başarısızlıkta 0 döner.
+    GLuint build(const AssetPack::View& vs, const AssetPack::View& fs) {
+        // Sürücü güncellenince eski ikililer geçersizleşir: anahtara sürücü kimliği de girer
+        string driver;
+        for (GLenum e : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            const GLubyte* str = glGetString(e);
+            if (str) driver += reinterpret_cast<const char*>(str);
+        }
+        uint64_t key = fnv1a(reinterpret_cast<const char*>(fs.data), fs.size, fnv1a(reinterpret_cast<const char*>(vs.data), vs.size, fnv1a(driver.data(), driver.size())));
+        char cachePath[256];
+        snprintf(cachePath, sizeof(cachePath), "shadercache/%s-%016llx.bin", name.c_str(), static_cast<unsigned long long>(key));
+
+        bool useCache = binaryCacheSupported();
+        if (useCache) {
+            string blob;
+            if (AssetPack::readFile(cachePath, blob) && blob.size() > sizeof(GLenum)) {
+                GLenum format;
+                memcpy(&format, blob.data(), sizeof(format));
+                GLuint program = glCreateProgram();
+                glProgramBinary(program, format, blob.data() + sizeof(format), static_cast<GLsizei>(blob.size() - sizeof(format)));
+                GLint ok = GL_FALSE;
+                glGetProgramiv(program, GL_LINK_STATUS, &ok);
+                if (ok) { ++cacheHits; return program; }
+                glDeleteProgram(program); // Bayat ya da reddedildi: derlemeye düş
+            }
+        }
 
-                rollTime += dt;
-                if (rollTime > rollDur) {
-                    rollTime = fmod(rollTime, rollDur);
+        GLuint vShader = compile(GL_VERTEX_SHADER, vs, vertexPath);
+        GLuint fShader = compile(GL_FRAGMENT_SHADER, fs, fragmentPath);
+        if (!vShader || !fShader) {
+            glDeleteShader(vShader); glDeleteShader(fShader);
+            return 0;
+        }
+        GLuint program = glCreateProgram();
+        if (useCache) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, vShader); glAttachShader(program, fShader);
+        if (!feedback.empty()) glTransformFeedbackVaryings(program, static_cast<GLsizei>(feedback.size()), feedback.data(), GL_INTERLEAVED_ATTRIBS);
+        glLinkProgram(program);
+        glDeleteShader(vShader); glDeleteShader(fShader);
+
+        GLint ok = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            GLint len = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
+            string log(len > 1 ? len : 1, '\0');
+            glGetProgramInfoLog(program, static_cast<GLsizei>(log.size()), nullptr, &log[0]);
+            std::cerr << "Shader " << name << ": link failed\n" << log.c_str() << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        ++compiled;
+
+        if (useCache) {
+            GLint length = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            if (length > 0) {
+                vector<char> blob(sizeof(GLenum) + length);
+                GLenum format = 0;
+                glGetProgramBinary(program, length, nullptr, &format, blob.data() + sizeof(GLenum));
+                memcpy(blob.data(), &format, sizeof(format));
+                if (FILE* f = fopen(cachePath, "wb")) {
+                    fwrite(blob.data(), 1, blob.size(), f);
+                    fclose(f);
                 }
             }
         }
-        else if (rolling) {
-            rollTime += dt;
-            if (rollTime >= stopRollDur) {
-                rolling = false;
-                rollTime = 0.0f;
-            }
+        return program;
+    }
+
+    // Kaynak eşlenmiş paketten gelebilir: sıfır sonlu değil, uzunlukla verilir
+    static GLuint compile(GLenum type, const AssetPack::View& source, const string& path) {
+        GLuint shader = glCreateShader(type);
+        const char* src = reinterpret_cast<const char*>(source.data);
+        GLint length = static_cast<GLint>(source.size);
+        glShaderSource(shader, 1, &src, &length); glCompileShader(shader);
+        GLint ok = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            GLint len = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len);
+            string log(len > 1 ? len : 1, '\0');
+            glGetShaderInfoLog(shader, static_cast<GLsizei>(log.size()), nullptr, &log[0]);
+            std::cerr << path << ": compile failed\n" << log.c_str() << std::endl;
+            glDeleteShader(shader);
+            return 0;
         }
+        return shader;
+    }
 
-        if (enableAbilities && dashing) {
-            dashTime += dt;
-            if (dashTime >= dashDur) {
-                dashing = false;
-                dashTime = 0.0f;
-                dashCool = maxDashCool;
+    void use() { glUseProgram(ID); }
+    void setMat4(const char* name, const glm::mat4& mat) {
+        glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, glm::value_ptr(mat));
+    }
+    void setVec4(const char* name, const glm::vec4& value) {
+        glUniform4fv(glGetUniformLocation(ID, name), 1, glm::value_ptr(value));
+    }
+    void setVec3(const char* name, const glm::vec3& value) {
+        glUniform3fv(glGetUniformLocation(ID, name), 1, glm::value_ptr(value));
+    }
+    void setFloat(const char* name, float value) {
+        glUniform1f(glGetUniformLocation(ID, name), value);
+    }
+    ~Shader() { glDeleteProgram(ID); }
+};
+
+int Shader::cacheHits = 0;
+int Shader::compiled = 0;
+double Shader::buildSeconds = 0.0;
+
+// Arena arenas/<ad>.arena dosyasından okunur: dış duvar (daire ya da çokgen), duvar, tribün, sütunlar, başlangıç noktaları.
+// Yüklemede serbest alanın işaretli uzaklık alanı (duvar/sütun yüzeyine uzaklık, içeride pozitif) ve gradyanı ızgaraya
+// pişirilir; çarpışma ve kamera itmesi arena ne kadar karmaşık olursa olsun sorgu başına O(1) örnekleme yapar.
+// Zemin, duvar, tribün ve sütun geometrisi de aynı veriden üretilir. Dış çizgi merkeze (0, 0) göre yıldız biçimli olmalı.
+class ArenaMap {
+public:
+    struct Pillar { glm::vec2 center; float radius, height; };
+
+    static const float bodyRadius; // Küp (oyuncu, kovalayıcı) ve kamera yarıçapı
+    static const float cellSize;   // SDF ızgara aralığı
+
+    string name;
+    vector<glm::vec2> outline;     // Duvarın dış yüzü, saat yönünün tersine
+    vector<Pillar> pillars;
+    float circleRadius;            // > 0: dış duvar tam daire (uzaklık analitik), 0: çokgen
+    float wallThickness, wallHeight, standsDepth, boundRadius;
+    glm::vec2 playerSpawn, chaserSpawn;
+
+    // Pişmiş alan SoA düzende: düğüm (i, j) = (origin + i * cellSize, origin + j * cellSize)
+    int res;
+    float origin;
+    vector<float> dist, gradX, gradZ;
+
+    ArenaMap() { setDefaults(); bake(); }
+
+    static ArenaMap& current() { static ArenaMap map; return map; }
+
+    // Dosya okunamazsa ya da geçersizse klasik arena (yarıçap 10, duvar 0.5) kullanılır
+    bool load(const string& arenaName) {
+        string path = "arenas/" + arenaName + ".arena", storage;
+        AssetPack::View src;
+        setDefaults();
+        bool ok = AssetPack::load(path, src, storage) && parse(string(reinterpret_cast<const char*>(src.data), src.size));
+        if (!ok) {
+            std::cerr << "Arena " << arenaName << ": cannot load " << path << ", using the classic arena" << std::endl;
+            setDefaults();
+        }
+        else name = arenaName;
+        bake();
+        return ok;
+    }
+
+    // Satır başına bir komut; # sonrası yorum
+    bool parse(const string& src) {
+        std::istringstream lines(src);
+        string line;
+        while (std::getline(lines, line)) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream in(line);
+            string cmd;
+            if (!(in >> cmd)) continue;
+            if (cmd == "circle") {
+                float r; int segments = 64;
+                if (!(in >> r) || r <= 0.0f) return false;
+                in >> segments;
+                circleRadius = r;
+                outline.clear();
+                for (int i = 0; i < glm::max(segments, 8); ++i) {
+                    float angle = 2.0f * glm::pi<float>() * i / glm::max(segments, 8);
+                    outline.push_back(glm::vec2(r * cos(angle), r * sin(angle)));
+                }
             }
-            else {
-                glm::vec3 dashDir = glm::normalize(glm::vec3(cam.front.x, 0.0f, cam.front.z));
-                glm::vec3 newPos = pos + dashDir * speed * dashSpeed * dt;
-
-                const float radius = 10.0f;
-                const float wallThickness = 0.5f;
-                float dist = glm::length(glm::vec2(newPos.x, newPos.z));
-                if (dist + 0.5f > radius - wallThickness) {
-                    float angle = atan2(newPos.z, newPos.x);
-                    newPos.x = (radius - wallThickness - 0.5f) * cos(angle);
-                    newPos.z = (radius - wallThickness - 0.5f) * sin(angle);
+            else if (cmd == "polygon") {
+                glm::vec2 p;
+                outline.clear();
+                circleRadius = 0.0f;
+                while (in >> p.x >> p.y) outline.push_back(p);
+                if (outline.size() < 3) return false;
+                float area = 0.0f;
+                for (size_t i = 0; i < outline.size(); ++i) {
+                    const glm::vec2& a = outline[i], & b = outline[(i + 1) % outline.size()];
+                    area += a.x * b.y - b.x * a.y;
                 }
-                pos = newPos;
+                if (area < 0.0f) std::reverse(outline.begin(), outline.end());
+            }
+            else if (cmd == "wall") { if (!(in >> wallThickness >> wallHeight)) return false; }
+            else if (cmd == "stands") { if (!(in >> standsDepth)) return false; }
+            else if (cmd == "pillar") {
+                Pillar p;
+                p.height = 3.0f;
+                if (!(in >> p.center.x >> p.center.y >> p.radius)) return false;
+                in >> p.height;
+                pillars.push_back(p);
             }
+            else if (cmd == "spawn") { if (!(in >> playerSpawn.x >> playerSpawn.y)) return false; }
+            else if (cmd == "chaser") { if (!(in >> chaserSpawn.x >> chaserSpawn.y)) return false; }
+            else { std::cerr << "Arena: unknown command " << cmd << std::endl; return false; }
         }
+        return true;
+    }
 
-        if (glfwGetKey(win.window, GLFW_KEY_SPACE) == GLFW_PRESS && !jumping) {
-            jumping = true;
-            jumpVel = jumpPower;
+    void setDefaults() {
+        name = "classic";
+        circleRadius = 10.0f;
+        outline.clear();
+        for (int i = 0; i < 64; ++i) {
+            float angle = 2.0f * glm::pi<float>() * i / 64;
+            outline.push_back(glm::vec2(circleRadius * cos(angle), circleRadius * sin(angle)));
         }
+        pillars.clear();
+        wallThickness = 0.5f; wallHeight = 5.0f; standsDepth = 3.0f;
+        playerSpawn = glm::vec2(0.0f);
+        chaserSpawn = glm::vec2(8.0f, 8.0f);
+    }
 
-        if (enableAbilities && glfwGetKey(win.window, GLFW_KEY_Q) == GLFW_PRESS && !jumping && superJumpCool <= 0.0f) {
-            jumping = true;
-            jumpVel = superJumpPower;
-            superJumpCool = maxSuperJumpCool;
-            superJumpUsed = true;
+    // Dış duvarın dış yüzüne işaretli uzaklık (içeride pozitif)
+    float outlineDistance(const glm::vec2& p) const {
+        if (circleRadius > 0.0f) return circleRadius - glm::length(p);
+        float best = 1e30f;
+        bool inside = false;
+        for (size_t i = 0, j = outline.size() - 1; i < outline.size(); j = i++) {
+            const glm::vec2& a = outline[j], & b = outline[i];
+            glm::vec2 ab = b - a;
+            float t = glm::clamp(glm::dot(p - a, ab) / glm::dot(ab, ab), 0.0f, 1.0f);
+            best = glm::min(best, glm::length(p - (a + ab * t)));
+            if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) / (b.y - a.y) * ab.x) inside = !inside;
         }
+        return inside ? best : -best;
+    }
 
-        if (jumping) {
-            pos.y += jumpVel * dt;
-            jumpVel -= gravity * dt;
-            if (pos.y <= 0.5f) {
-                pos.y = 0.5f;
-                jumping = false;
-                jumpVel = 0.0f;
-                if (enableAbilities && superJumpUsed) {
-                    waveTriggered = true;
-                    superJumpUsed = false;
-                }
+    // Serbest alanın tam (pişirilmemiş) uzaklığı: duvarın iç yüzü ve sütunlar
+    float exactDistance(const glm::vec2& p) const {
+        float d = outlineDistance(p) - wallThickness;
+        for (const Pillar& pl : pillars) d = glm::min(d, glm::length(p - pl.center) - pl.radius);
+        return d;
+    }
+
+    void bake() {
+        boundRadius = 0.0f;
+        for (const glm::vec2& v : outline) boundRadius = glm::max(boundRadius, glm::length(v));
+        origin = -(boundRadius + 1.0f);
+        res = static_cast<int>(ceil(-2.0f * origin / cellSize)) + 1;
+        dist.assign(res * res, 0.0f);
+        gradX.assign(res * res, 0.0f);
+        gradZ.assign(res * res, 0.0f);
+        for (int j = 0; j < res; ++j)
+            for (int i = 0; i < res; ++i) dist[j * res + i] = exactDistance(glm::vec2(origin + i * cellSize, origin + j * cellSize));
+        // Merkezi farklarla birim gradyan; kenarlarda tek yönlü fark
+        for (int j = 0; j < res; ++j) {
+            for (int i = 0; i < res; ++i) {
+                int i0 = glm::max(i - 1, 0), i1 = glm::min(i + 1, res - 1), j0 = glm::max(j - 1, 0), j1 = glm::min(j + 1, res - 1);
+                glm::vec2 g((dist[j * res + i1] - dist[j * res + i0]) / (i1 - i0), (dist[j1 * res + i] - dist[j0 * res + i]) / (j1 - j0));
+                float len = glm::length(g);
+                if (len > 1e-6f) g = g / len;
+                gradX[j * res + i] = g.x;
+                gradZ[j * res + i] = g.y;
+            }
+        }
+    }
+
+    // Toplu örnekleme: SoA giriş/çıkış, dallanmasız çift doğrusal karışım; döngü derleyici tarafından vektörleştirilebilir
+    void sample(const float* x, const float* z, float* d, float* gx, float* gz, size_t n) const {
+        const float inv = 1.0f / cellSize, maxF = res - 1.001f;
+        const float* D = dist.data(), * GX = gradX.data(), * GZ = gradZ.data();
+        for (size_t k = 0; k < n; ++k) {
+            float fx = std::min(std::max((x[k] - origin) * inv, 0.0f), maxF), fz = std::min(std::max((z[k] - origin) * inv, 0.0f), maxF);
+            int ix = static_cast<int>(fx), iz = static_cast<int>(fz), c = iz * res + ix;
+            float tx = fx - ix, tz = fz - iz;
+            float w00 = (1.0f - tx) * (1.0f - tz), w10 = tx * (1.0f - tz), w01 = (1.0f - tx) * tz, w11 = tx * tz;
+            d[k] = D[c] * w00 + D[c + 1] * w10 + D[c + res] * w01 + D[c + res + 1] * w11;
+            gx[k] = GX[c] * w00 + GX[c + 1] * w10 + GX[c + res] * w01 + GX[c + res + 1] * w11;
+            gz[k] = GZ[c] * w00 + GZ[c + 1] * w10 + GZ[c + res] * w01 + GZ[c + res + 1] * w11;
+        }
+    }
+
+    float distance(const glm::vec2& p) const {
+        float d, gx, gz;
+        sample(&p.x, &p.y, &d, &gx, &gz, 1);
+        return d;
+    }
+
+    // Yarıçapı radius olan gövdeyi gradyan boyunca serbest alana iter; köşelerde gradyan kırıldığı için üç adıma kadar
+    glm::vec2 push(glm::vec2 p, float radius) const {
+        for (int step = 0; step < 3; ++step) {
+            float d, gx, gz;
+            sample(&p.x, &p.y, &d, &gx, &gz, 1);
+            if (d >= radius) break;
+            p += glm::vec2(gx, gz) * (radius - d);
+        }
+        return p;
+    }
+
+    glm::vec3 push(const glm::vec3& p, float radius) const {
+        glm::vec2 q = push(glm::vec2(p.x, p.z), radius);
+        return glm::vec3(q.x, p.y, q.y);
+    }
+
+    // Toplu itme (sunucudaki kovalayıcılar); d/gx/gz çağıranın n boyutlu geçici dizileri
+    void push(float* x, float* z, float* d, float* gx, float* gz, size_t n, float radius) const {
+        for (int step = 0; step < 3; ++step) {
+            sample(x, z, d, gx, gz, n);
+            for (size_t k = 0; k < n; ++k) {
+                float depth = std::max(radius - d[k], 0.0f);
+                x[k] += gx[k] * depth;
+                z[k] += gz[k] * depth;
+            }
+        }
+    }
+
+    // Merkezden angle yönünde dış çizgiye uzaklık (tribündeki seyirci yerleşimi için)
+    float outlineRadius(float angle) const {
+        if (circleRadius > 0.0f) return circleRadius;
+        glm::vec2 dir(cos(angle), sin(angle));
+        float best = boundRadius;
+        for (size_t i = 0, j = outline.size() - 1; i < outline.size(); j = i++) {
+            glm::vec2 a = outline[j], e = outline[i] - a;
+            float den = dir.x * e.y - dir.y * e.x;
+            if (fabs(den) < 1e-6f) continue;
+            float t = (a.x * e.y - a.y * e.x) / den, s = (a.x * dir.y - a.y * dir.x) / den;
+            if (t > 0.0f && s >= 0.0f && s <= 1.0f) best = glm::min(best, t);
+        }
+        return best;
+    }
+
+    // i. köşe, dış çizgiye dik olarak amount kadar dışarı (negatifse içeri) kaydırılmış
+    glm::vec2 offset(size_t i, float amount) const {
+        const glm::vec2& v = outline[i % outline.size()];
+        if (circleRadius > 0.0f) return v * ((circleRadius + amount) / circleRadius);
+        const glm::vec2& prev = outline[(i + outline.size() - 1) % outline.size()], & next = outline[(i + 1) % outline.size()];
+        glm::vec2 e0 = glm::normalize(v - prev), e1 = glm::normalize(next - v);
+        glm::vec2 n0(e0.y, -e0.x), n1(e1.y, -e1.x), miter = glm::normalize(n0 + n1);
+        return v + miter * (amount / glm::max(glm::dot(miter, n1), 0.25f));
+    }
+};
+
+const float ArenaMap::bodyRadius = 0.5f;
+const float ArenaMap::cellSize = 0.125f;
+
+class Camera {
+public:
+    glm::vec3 pos;
+    glm::vec3 front;
+    glm::vec3 up;
+    glm::mat4 view;
+    glm::mat4 proj;
+    float w, h;
+    float yaw, pitch;
+    double lastX, lastY;
+    bool firstMouse;
+    glm::vec3 target;
+    float dist;
+    float mouseSensitivity; 
+    float farPlane;
+
+    Camera(float width, float height) : pos(0.0f, 5.0f, -5.0f), front(0.0f, 0.0f, -1.0f), up(0.0f, 1.0f, 0.0f),
+        w(width), h(height), yaw(-90.0f), pitch(-15.0f), lastX(width / 2.0), lastY(height / 2.0), firstMouse(true),
+        target(0.0f, 0.5f, 0.0f), dist(7.0f), mouseSensitivity(0.5f), farPlane(Settings::current().quality.farPlane) { 
+        proj = glm::perspective(glm::radians(45.0f), w / h, 0.1f, farPlane);
+        updateView(0.016f);
+    }
+
+    void updateView(float dt) {
+        glm::vec3 dir;
+        dir.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+        dir.y = sin(glm::radians(pitch));
+        dir.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+        front = glm::normalize(dir);
+
+        glm::vec3 desiredPos = target - (front * dist);
+        desiredPos.y = target.y + 3.0f; 
+
+        // Wall conflict: kamerayı duvar ve sütunlardan arena içine it, dist değişmez
+        desiredPos = ArenaMap::current().push(desiredPos, ArenaMap::bodyRadius);
+
+        pos = desiredPos;
+        view = glm::lookAt(pos, target, up);
+    }
+
+    void mouseInput(Window& win, double xpos, double ypos) {
+        if (firstMouse) {
+            lastX = xpos;
+            lastY = ypos;
+            firstMouse = false;
+        }
+
+        float xoff = static_cast<float>(xpos - lastX);
+        float yoff = static_cast<float>(lastY - ypos);
+        lastX = xpos;
+        lastY = ypos;
+
+        // Apply mouseSensitivity to scale the offsets
+        xoff *= 0.2f * mouseSensitivity;
+        yoff *= 0.2f * mouseSensitivity;
+
+        yaw += xoff;
+        pitch += yoff;
+
+        if (pitch > 45.0f) pitch = 45.0f;
+        if (pitch < -45.0f) pitch = -45.0f;
+
+        updateView(0.016f);
+    }
+
+    void setTarget(const glm::vec3& newTarget) {
+        target = newTarget + glm::vec3(0.0f, 0.5f, 0.0f);
+    }
+
+    glm::vec3 getRight() const {
+        return glm::normalize(glm::cross(up, front));
+    }
+};
+
+class Mesh {
+public:
+    GLuint VAO, VBO, EBO;
+    vector<GLfloat> verts;
+    vector<GLuint> inds;
+
+    Mesh(const vector<GLfloat>& vertices, const vector<GLuint>& indices) : verts(vertices), inds(indices) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, inds.size() * sizeof(GLuint), inds.data(), GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        glBindVertexArray(0);
+    }
+
+    void draw() {
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, inds.size(), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+
+    ~Mesh() {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+};
+
+class TextureMesh {
+public:
+    GLuint VAO, VBO, EBO;
+    vector<GLfloat> verts;
+    vector<GLuint> inds;
+
+    // Varsayılan constructor (UI için, 2D vertex'ler)
+    TextureMesh() {
+        // 2D dörtgen için vertex'ler: pozisyon (x, y) ve doku koordinatları (u, v)
+        verts = {
+            -125.0f, -125.0f,  0.0f, 0.0f,  // Sol alt (150x150 piksel)
+             125.0f, -125.0f,  1.0f, 0.0f,  // Sağ alt
+             125.0f,  125.0f,  1.0f, 1.0f,  // Sağ üst
+            -125.0f,  125.0f,  0.0f, 1.0f   // Sol üst
+        };
+
+        inds = {
+            0, 1, 2,
+            2, 3, 0
+        };
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, inds.size() * sizeof(GLuint), inds.data(), GL_STATIC_DRAW);
+
+        // Pozisyon (2) + Doku koordinatları (2)
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)(2 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+    }
+
+    // Parametreli constructor (zemin için, 3D vertex'ler)
+    TextureMesh(const vector<GLfloat>& vertices, const vector<GLuint>& indices) : verts(vertices), inds(indices) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(GLfloat), verts.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, inds.size() * sizeof(GLuint), inds.data(), GL_STATIC_DRAW);
+
+        // Pozisyon (3) + Doku koordinatları (2)
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+    }
+
+    void draw() const {
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, inds.size(), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+
+    ~TextureMesh() {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+};
+
+class Texture {
+public:
+    GLuint ID;
+    int width, height;
+
+    Texture(const char* path) {
+        TRACE_SCOPE("texture load");
+        glGenTextures(1, &ID);
+        bind();
+
+        const QualitySettings& quality = Settings::current().quality;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, quality.mipBias);
+
+        // Paketteki çözülmüş pikseller eşlemeden doğrudan yüklenir; yoksa bellekteki PNG ya da gevşek dosya çözülür
+        AssetPack::View packed;
+        bool inPack = AssetPack::current().find(path, packed);
+        unsigned char* data = nullptr;
+        const unsigned char* pixels = nullptr;
+        stbi_set_flip_vertically_on_load(true);
+        if (inPack && packed.format == AssetPack::RGBA8) {
+            pixels = packed.data;
+            width = packed.width;
+            height = packed.height;
+        }
+        else pixels = data = inPack ? stbi_load_from_memory(packed.data, static_cast<int>(packed.size), &width, &height, nullptr, 4) : stbi_load(path, &width, &height, nullptr, 4);
+        vector<unsigned char> reduced;
+        while (pixels && (width > quality.maxTextureSize || height > quality.maxTextureSize) && width > 1 && height > 1)
+            pixels = halve(pixels, width, height, reduced);
+        if (pixels) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        else {
+            std::cerr << "Failed to load texture: " << path << std::endl;
+            unsigned char white[] = { 255, 255, 255, 255 };
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+            width = height = 1;
+        }
+        stbi_image_free(data);
+    }
+
+    // 2x2 kutu filtresiyle yarı boyut (tek kenarlarda son satır/sütun atılır); sonuç out'ta
+    static const unsigned char* halve(const unsigned char* src, int& w, int& h, vector<unsigned char>& out) {
+        int hw = w / 2, hh = h / 2;
+        vector<unsigned char> half(static_cast<size_t>(hw) * hh * 4);
+        for (int y = 0; y < hh; ++y) for (int x = 0; x < hw; ++x) for (int c = 0; c < 4; ++c) {
+            const unsigned char* p = src + (static_cast<size_t>(y) * 2 * w + x * 2) * 4 + c;
+            half[(static_cast<size_t>(y) * hw + x) * 4 + c] = static_cast<unsigned char>((p[0] + p[4] + p[w * 4] + p[w * 4 + 4] + 2) / 4);
+        }
+        out.swap(half);
+        w = hw; h = hh;
+        return out.data();
+    }
+
+    // Bellekteki RGBA piksellerden (ör. düz renkli UI dörtgenleri için 1x1 beyaz)
+    Texture(const unsigned char* rgba, int w, int h) : width(w), height(h) {
+        glGenTextures(1, &ID);
+        bind();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    }
+
+    void bind(GLenum textureUnit = GL_TEXTURE0) const {
+        glActiveTexture(textureUnit);
+        glBindTexture(GL_TEXTURE_2D, ID);
+    }
+
+    ~Texture() {
+        glDeleteTextures(1, &ID);
+    }
+};
+
+// Kare başına değişen tüm köşe/instance verileri için tek halka tampon. ARB_buffer_storage varsa kalıcı ve tutarlı
+// eşlenir (yazılan veri doğrudan GPU'ya görünür); yoksa her yükleme GL_MAP_UNSYNCHRONIZED_BIT ile eşlenir.
+// Halka SEGMENTS bölgeye ayrılır; bir bölgeden çıkarken çit konur, bölgeye yeniden girerken GPU'nun onu bitirdiği
+// çitle doğrulanır. Bölge bir kareden büyük tutulduğundan bu denetim normalde beklemeden geçer.
+class StreamBuffer {
+public:
+    enum { SEGMENTS = 4 };
+    GLuint VBO;
+    size_t size, head, stalls, orphans;
+    bool persistent;
+
+    static StreamBuffer& current() {
+        StreamBuffer& stream = instance();
+        if (!stream.VBO) stream.init(16 << 20); // İlk kullanım GL bağlamı açıldıktan sonra
+        return stream;
+    }
+
+    // GL bağlamı kapanmadan çağrılmalı; statik yıkıcı GL'ye dokunmaz
+    static void shutdown() { instance().release(); }
+
+    // data'yı halkaya kopyalar ve tampon içindeki bayt konumunu döner (align'ın katı: köşe adımıyla eşleşsin)
+    // Yüklenen aralığı okuyan çizimler bir sonraki upload'dan önce gönderilmeli (bölge çitleri buna dayanır)
+    size_t upload(const void* data, size_t bytes, size_t align = 16) {
+        size_t offset = reserve(bytes, align);
+        if (persistent) memcpy(mapped + offset, data, bytes);
+        else {
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            void* p = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            if (p) {
+                memcpy(p, data, bytes);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+        }
+        return offset;
+    }
+
+private:
+    char* mapped;
+    GLsync fences[SEGMENTS];
+    int writing; // Yazılmakta olan bölge, -1: yok
+
+    static StreamBuffer& instance() {
+        static StreamBuffer stream;
+        return stream;
+    }
+
+    StreamBuffer() : VBO(0), size(0), head(0), stalls(0), orphans(0), persistent(false), mapped(nullptr), writing(-1) {
+        for (GLsync& f : fences) f = 0;
+    }
+
+    void init(size_t bytes) {
+        size = bytes;
+        head = 0;
+        writing = -1;
+        persistent = GLEW_ARB_buffer_storage != 0;
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        if (persistent) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+            mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+            persistent = mapped != nullptr;
+        }
+        if (!persistent) {
+            if (GLEW_ARB_buffer_storage) { // Değişmez depo eşlenemedi: yeniden boyutlanabilir bir tamponla başla
+                glDeleteBuffers(1, &VBO);
+                glGenBuffers(1, &VBO);
+                glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            }
+            glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void release() {
+        for (GLsync& f : fences) if (f) { glDeleteSync(f); f = 0; }
+        if (!VBO) return;
+        if (mapped) {
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &VBO);
+        VBO = 0;
+        mapped = nullptr;
+    }
+
+    size_t reserve(size_t bytes, size_t align) {
+        size_t segment = size / SEGMENTS;
+        if (bytes > segment) {
+            // Tek yükleme bir bölgeyi aşıyor: halkayı büyüt. Eski tamponu GL, kullanan çizimler bitince siler;
+            // tüketiciler tamponu her çizimde VBO üzerinden bağladığından kimse eski adı tutmaz
+            release();
+            size_t grown = size;
+            while (bytes > grown / SEGMENTS) grown *= 2;
+            init(grown);
+            segment = size / SEGMENTS;
+        }
+        size_t start = (head + align - 1) / align * align;
+        // Bir yükleme iki bölgeye yayılmaz: bölge sonuna sığmıyorsa sonraki bölgenin başına (gerekirse halkanın başına) atla.
+        // Yayılsaydı geride kalan bölgenin çiti, o yüklemeyi okuyan çizim gönderilmeden kurulurdu
+        size_t s = start / segment;
+        if (start + bytes > (s + 1) * segment) start = ++s * segment;
+        if (s >= SEGMENTS) start = s = 0;
+        if (static_cast<int>(s) != writing) {
+            // Bölge değişiyor: geride kalanın yüklemelerini okuyan çizimler gönderildi (her upload, sonrakinden önce
+            // çizilir), çitlenir; girilenin GPU'da bitmiş olması gerekir
+            if (writing >= 0) fence(writing);
+            acquire(s);
+            writing = static_cast<int>(s);
+        }
+        head = start + bytes;
+        return start;
+    }
+
+    void fence(size_t s) {
+        if (fences[s]) glDeleteSync(fences[s]);
+        fences[s] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void acquire(size_t s) {
+        if (!fences[s]) return;
+        GLenum state = glClientWaitSync(fences[s], 0, 0);
+        if (state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED) {
+            if (!persistent) {
+                // Eski yol: beklemek yerine tamponu yetim bırak, sürücü yeni bir depo verir
+                glBindBuffer(GL_ARRAY_BUFFER, VBO);
+                glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                for (GLsync& f : fences) if (f) { glDeleteSync(f); f = 0; }
+                ++orphans;
+                return;
+            }
+            ++stalls; // GPU halkanın bir turundan fazla geride: beklemek zorunlu
+            glClientWaitSync(fences[s], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        }
+        glDeleteSync(fences[s]);
+        fences[s] = 0;
+    }
+};
+
+// Konum, eksen-açı dönüşü ve ölçekten oluşan yerel dönüşüm; yerel ve dünya matrisi önbellekte tutulur.
+// Matris yalnızca bir bileşen gerçekten değişince yeniden kurulur, ebeveyni olanın dünya matrisi de ebeveynin sürümü
+// değişince. Sabit nesneler matrislerini bir kez hesaplar; kare başına matris işi sahne boyutuyla değil, hareket edenle ölçeklenir.
+class Transform {
+public:
+    explicit Transform(const glm::vec3& position = glm::vec3(0.0f), const glm::vec3& scale = glm::vec3(1.0f), const Transform* parent = nullptr)
+        : position(position), scale(scale), axis(0.0f, 1.0f, 0.0f), angle(0.0f), parent(parent), parentVersion(0), version(0), dirty(true), worldDirty(true) {}
+
+    void setPosition(const glm::vec3& p) { if (p != position) { position = p; dirty = true; } }
+    void setScale(const glm::vec3& s) { if (s != scale) { scale = s; dirty = true; } }
+    void setRotation(float a, const glm::vec3& ax) {
+        if (a != angle || (a != 0.0f && ax != axis)) { angle = a; axis = ax; dirty = true; }
+    }
+    void setParent(const Transform* p) { parent = p; worldDirty = true; }
+
+    const glm::mat4& local() const {
+        if (dirty) {
+            localMatrix = glm::translate(glm::mat4(1.0f), position);
+            if (angle != 0.0f) localMatrix = glm::rotate(localMatrix, angle, axis);
+            if (scale != glm::vec3(1.0f)) localMatrix = glm::scale(localMatrix, scale);
+            dirty = false;
+            worldDirty = true;
+            rebuilds()++;
+        }
+        return localMatrix;
+    }
+
+    const glm::mat4& world() const {
+        local();
+        if (!parent) {
+            if (worldDirty) { worldDirty = false; ++version; }
+            return localMatrix;
+        }
+        const glm::mat4& parentWorld = parent->world();
+        if (worldDirty || parentVersion != parent->version) {
+            worldMatrix = parentWorld * localMatrix;
+            parentVersion = parent->version;
+            worldDirty = false;
+            ++version;
+            rebuilds()++;
+        }
+        return worldMatrix;
+    }
+
+    // Yeniden kurulan matris sayısı (render iş parçacığı); F3 kare başına gösterir
+    static size_t& rebuilds() { static size_t n = 0; return n; }
+
+private:
+    glm::vec3 position, scale, axis;
+    float angle;
+    const Transform* parent;
+    mutable glm::mat4 localMatrix, worldMatrix;
+    mutable unsigned parentVersion, version; // version: dünya matrisi her değiştiğinde artar
+    mutable bool dirty, worldDirty;
+};
+
+// İşçilerin hazırladığı tek çizim: matris ve renk GL'siz hesaplanır, render iş parçacığı yalnızca gönderir
+struct DrawCmd {
+    glm::mat4 model;
+    glm::vec4 color; // w == 0: atla
+};
+
+class Renderer {
+public:
+    // Aynı mesh ve shader'la bir komut dizisi: view/projection bir kez, komut başına yalnızca model ve renk
+    void submit(const Mesh& mesh, Shader& shader, const glm::mat4& view, const glm::mat4& proj, const DrawCmd* cmds, size_t count) {
+        shader.use();
+        shader.setMat4("view", view);
+        shader.setMat4("projection", proj);
+        glBindVertexArray(mesh.VAO);
+        for (size_t i = 0; i < count; ++i) {
+            if (cmds[i].color.w == 0.0f) continue;
+            shader.setMat4("model", cmds[i].model);
+            shader.setVec4("color", cmds[i].color);
+            glDrawElements(GL_TRIANGLES, mesh.inds.size(), GL_UNSIGNED_INT, 0);
+        }
+        glBindVertexArray(0);
+    }
+
+    void draw(const Mesh& mesh, Shader& shader, const glm::mat4& view, const glm::mat4& proj, const glm::mat4& model, const glm::vec4& color) {
+        shader.use();
+        shader.setMat4("model", model);
+        shader.setMat4("view", view);
+        shader.setMat4("projection", proj);
+        shader.setVec4("color", color);
+
+        glBindVertexArray(mesh.VAO);
+        glDrawElements(GL_TRIANGLES, mesh.inds.size(), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+
+    // Tek bir drawTexture fonksiyonu: hem 3D hem 2D için kullanılabilir
+    void drawTexture(const TextureMesh& mesh, Shader& shader, Texture& texture,
+        const glm::mat4& model, const glm::mat4& view, const glm::mat4& proj,
+        const glm::vec4& colorTint, bool is2D = false) {
+        shader.use();
+        shader.setMat4("model", model);
+        if (!is2D) {
+            shader.setMat4("view", view);
+        }
+        shader.setMat4("projection", proj);
+        shader.setVec4("colorTint", colorTint);
+
+        texture.bind(GL_TEXTURE0); // Artık parametre kabul ediyor
+        glUniform1i(glGetUniformLocation(shader.ID, "texture1"), 0);
+
+        if (is2D) {
+            glDisable(GL_DEPTH_TEST);
+        }
+        mesh.draw();
+        if (is2D) {
+            glEnable(GL_DEPTH_TEST);
+        }
+    }
+};
+
+// 3B geçiş pencere boyutundaki FBO'nun sol-alt alt dikdörtgenine ölçekli çözünürlükte çizilir, sonra pencereye
+// keskinleştirmeli çift doğrusal büyütülür; HUD ve metin doğal çözünürlükte üstüne çizilir.
+// Ölçek, 3B geçişin GL_TIME_ELAPSED ile ölçülen GPU süresinden (piksel başına maliyet) hedef kare süresine oturtulur.
+class DynamicResolution {
+public:
+    enum { IN_FLIGHT = 4 };
+
+    GLuint fbo, color, depth, vao, queries[IN_FLIGHT];
+    float queryScale[IN_FLIGHT];  // Sorgunun ölçtüğü karenin ölçeği, 0 = boşta
+    int queryIndex;
+    int fullW, fullH, w, h;       // FBO (pencere) boyutu ve bu karede çizilen alan
+    float scale, minScale, maxScale, targetMs, budget, sharpness;
+    float costPerArea;            // ms / ölçek^2, üssel ortalama; 0 = henüz ölçüm yok
+    double lastChange;
+
+    DynamicResolution() : fbo(0), color(0), depth(0), vao(0), queryIndex(0), fullW(0), fullH(0), w(0), h(0), scale(1.0f), minScale(0.5f), maxScale(1.0f),
+        targetMs(1000.0f / 60.0f), budget(0.8f), sharpness(0.3f), costPerArea(0.0f), lastChange(0.0) {
+        for (int i = 0; i < IN_FLIGHT; ++i) { queries[i] = 0; queryScale[i] = 0.0f; }
+    }
+
+    void init(int width, int height) {
+        glGenFramebuffers(1, &fbo);
+        glGenTextures(1, &color);
+        glGenRenderbuffers(1, &depth);
+        glGenVertexArrays(1, &vao);
+        glGenQueries(IN_FLIGHT, queries);
+        resize(width, height);
+    }
+
+    // Depolama pencere boyutunda bir kez ayrılır; ölçek değişimi yalnızca viewport'u değiştirir
+    void resize(int width, int height) {
+        fullW = width; fullH = height;
+        glBindTexture(GL_TEXTURE_2D, color);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, fullW, fullH, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, fullW, fullH);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) std::cerr << "Dynamic resolution: framebuffer incomplete" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Biten sorguları topla (beklemeden), ölçeği güncelle, FBO'yu bağla ve zamanlamayı başlat
+    void begin(int width, int height, double now) {
+        if (width != fullW || height != fullH) resize(width, height);
+        collect();
+        adapt(now);
+        w = glm::max(1, static_cast<int>(fullW * scale + 0.5f));
+        h = glm::max(1, static_cast<int>(fullH * scale + 0.5f));
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, w, h);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (queryScale[queryIndex] == 0.0f) {
+            glBeginQuery(GL_TIME_ELAPSED, queries[queryIndex]);
+            queryScale[queryIndex] = -scale; // Negatif: sorgu açık
+        }
+    }
+
+    // Zamanlamayı kapat, pencereye (ya da ekransız hedefe) büyüt; sonrası (HUD) doğal çözünürlükte
+    void end(Shader& upscale, GLuint target = 0) {
+        if (queryScale[queryIndex] < 0.0f) {
+            glEndQuery(GL_TIME_ELAPSED);
+            queryScale[queryIndex] = -queryScale[queryIndex];
+            queryIndex = (queryIndex + 1) % IN_FLIGHT;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glViewport(0, 0, fullW, fullH);
+        glDisable(GL_DEPTH_TEST);
+        upscale.use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, color);
+        glUniform1i(glGetUniformLocation(upscale.ID, "scene"), 0);
+        glUniform2f(glGetUniformLocation(upscale.ID, "uvScale"), static_cast<float>(w) / fullW, static_cast<float>(h) / fullH);
+        glUniform2f(glGetUniformLocation(upscale.ID, "texel"), 1.0f / fullW, 1.0f / fullH);
+        upscale.setFloat("sharpness", scale < 1.0f ? sharpness : 0.0f);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    ~DynamicResolution() {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (color) glDeleteTextures(1, &color);
+        if (depth) glDeleteRenderbuffers(1, &depth);
+        if (vao) glDeleteVertexArrays(1, &vao);
+        if (queries[0]) glDeleteQueries(IN_FLIGHT, queries);
+    }
+
+private:
+    void collect() {
+        for (int i = 0; i < IN_FLIGHT; ++i) {
+            if (queryScale[i] <= 0.0f) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) continue;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &ns);
+            float cost = static_cast<float>(ns * 1e-6) / (queryScale[i] * queryScale[i]);
+            costPerArea = costPerArea > 0.0f ? glm::mix(costPerArea, cost, 0.2f) : cost;
+            queryScale[i] = 0.0f;
+        }
+    }
+
+    // Maliyet alanla (ölçeğin karesiyle) orantılı kabul edilir; titremeyi önlemek için küçük farklar
+    // yok sayılır, değişiklikler çeyrek saniyede bir ve en fazla 0.1 adımla yapılır
+    void adapt(double now) {
+        if (costPerArea <= 0.0f || maxScale <= minScale || now - lastChange < 0.25) return;
+        float desired = glm::clamp(sqrt(targetMs * budget / costPerArea), minScale, maxScale);
+        if (fabs(desired - scale) < 0.03f) return;
+        scale = glm::clamp(desired, scale - 0.1f, scale + 0.1f);
+        lastChange = now;
+    }
+};
+
+// GPU parçacıkları: yayım ve tümleme transform feedback ile iki tampon arasında gidip gelir, CPU kare başına
+// yalnızca birkaç uniform ve iki çizim çağrısı yapar. Yuvalar bir halka gibi kullanılır: her kare imleçten
+// itibaren yayılan sayıda yuva yeniden doğar (en eskiler geri dönüşür), yer ayırma ya da geri okuma yok.
+class ParticleSystem {
+public:
+    enum Kind { DASH = 0, DEBRIS = 1, CONFETTI = 2, SPARK = 3 };
+    enum { MAX_EMITTERS = 8 };
+
+    struct Emitter { glm::vec4 pos, vel, shape; };
+
+    GLuint vbo[2], updateVAO[2], drawVAO[2];
+    int capacity, cursor, src, emitterCount, emitted;
+    Emitter emitters[MAX_EMITTERS];
+    glm::vec4 emitPos[MAX_EMITTERS], emitVel[MAX_EMITTERS], emitShape[MAX_EMITTERS];
+    double aliveUntil; // Bu andan sonra canlı parçacık kalmaz: benzetim ve çizim atlanır
+    uint32_t frame;
+
+    ParticleSystem() : capacity(0), cursor(0), src(0), emitterCount(0), emitted(0), aliveUntil(-1.0), frame(0) {
+        vbo[0] = vbo[1] = updateVAO[0] = updateVAO[1] = drawVAO[0] = drawVAO[1] = 0;
+    }
+
+    void init(int maxParticles) {
+        capacity = glm::max(maxParticles, 1);
+        vector<glm::vec4> zero(static_cast<size_t>(capacity) * 2, glm::vec4(0.0f)); // Ömür 0: hepsi ölü başlar
+        glGenBuffers(2, vbo);
+        glGenVertexArrays(2, updateVAO);
+        glGenVertexArrays(2, drawVAO);
+        for (int i = 0; i < 2; ++i) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo[i]);
+            glBufferData(GL_ARRAY_BUFFER, zero.size() * sizeof(glm::vec4), zero.data(), GL_DYNAMIC_COPY);
+            for (GLuint vao : { updateVAO[i], drawVAO[i] }) {
+                glBindVertexArray(vao);
+                glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec4), (void*)0);
+                glEnableVertexAttribArray(0);
+                glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec4), (void*)sizeof(glm::vec4));
+                glEnableVertexAttribArray(1);
+            }
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // Bu karenin yayımı; ringRadius > 0 ise parçacıklar halka üzerinde doğup dışarı doğru speed ile saçılır
+    void emit(Kind kind, const glm::vec3& pos, const glm::vec3& vel, float speed, float ringRadius, float life, int count, double now) {
+        count = glm::min(count, capacity - emitted);
+        if (count <= 0 || emitterCount == MAX_EMITTERS) return;
+        Emitter& e = emitters[emitterCount++];
+        e.pos = glm::vec4(pos.x, pos.y, pos.z, static_cast<float>(kind));
+        e.vel = glm::vec4(vel.x, vel.y, vel.z, speed);
+        e.shape = glm::vec4(ringRadius, life, static_cast<float>(emitted), static_cast<float>(count));
+        emitted += count;
+        aliveUntil = std::max(aliveUntil, now + life);
+    }
+
+    void update(Shader& program, float dt, double now) {
+        if (!capacity || (now > aliveUntil && !emitterCount)) return;
+        TRACE_SCOPE("particles");
+        for (int i = 0; i < emitterCount; ++i) { emitPos[i] = emitters[i].pos; emitVel[i] = emitters[i].vel; emitShape[i] = emitters[i].shape; }
+        int dst = 1 - src;
+        program.use();
+        glUniform1i(glGetUniformLocation(program.ID, "capacity"), capacity);
+        glUniform1i(glGetUniformLocation(program.ID, "cursor"), cursor);
+        glUniform1i(glGetUniformLocation(program.ID, "emitterCount"), emitterCount);
+        glUniform1ui(glGetUniformLocation(program.ID, "seed"), ++frame * 2654435761u);
+        glUniform4fv(glGetUniformLocation(program.ID, "emitPos"), MAX_EMITTERS, glm::value_ptr(emitPos[0]));
+        glUniform4fv(glGetUniformLocation(program.ID, "emitVel"), MAX_EMITTERS, glm::value_ptr(emitVel[0]));
+        glUniform4fv(glGetUniformLocation(program.ID, "emitShape"), MAX_EMITTERS, glm::value_ptr(emitShape[0]));
+        program.setFloat("dt", dt);
+        program.setFloat("floorY", 0.05f);
+
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(updateVAO[src]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, vbo[dst]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, capacity);
+        glEndTransformFeedback();
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glBindVertexArray(0);
+        glDisable(GL_RASTERIZER_DISCARD);
+
+        src = dst;
+        cursor = (cursor + emitted) % capacity;
+        emitterCount = emitted = 0;
+    }
+
+    // Saydam noktalar derinliğe yazmaz; viewportHeight noktaların dünya boyutunu piksele çevirir
+    void draw(Shader& program, const glm::mat4& view, const glm::mat4& proj, float viewportHeight, double now) {
+        if (!capacity || now > aliveUntil) return;
+        program.use();
+        program.setMat4("view", view);
+        program.setMat4("projection", proj);
+        program.setFloat("pointScale", viewportHeight * proj[1][1] * 0.5f);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glDepthMask(GL_FALSE);
+        glBindVertexArray(drawVAO[src]);
+        glDrawArrays(GL_POINTS, 0, capacity);
+        glBindVertexArray(0);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+    }
+
+    ~ParticleSystem() {
+        if (vbo[0]) glDeleteBuffers(2, vbo);
+        if (updateVAO[0]) glDeleteVertexArrays(2, updateVAO);
+        if (drawVAO[0]) glDeleteVertexArrays(2, drawVAO);
+    }
+};
+
+// Kare yakalama: her bitmiş kare bir PBO halkasına okunur (glReadPixels GPU'yu beklemeden döner) ve IN_FLIGHT - 1
+// kare sonra, GPU kopyayı çoktan bitirmişken eşlenip havuzdaki bir tampona alınır. Kodlama arka plandaki iş parçacığında:
+// .y4m ise ham YUV 4:2:0 akışı, değilse numaralı PNG dizisi. Havuz doluysa render iş parçacığı bekler; kare atlanmaz,
+// sabit adımlı kayıtlar belirlenimci kalır.
+class FrameCapture {
+public:
+    enum { IN_FLIGHT = 4, POOL = 8 };
+    int w, h, fps;
+    size_t frames, waits; // Kodlayıcıya verilen kareler, boş tampon beklenen kareler
+    bool active;
+
+    FrameCapture() : w(0), h(0), fps(60), frames(0), waits(0), active(false), issued(0), collected(0),
+        out(nullptr), y4m(false), stop(false), queueHead(0), queueTail(0), freeCount(0), written(0) {
+        for (GLsync& f : fences) f = 0;
+    }
+
+    // Boyut kayıt boyunca sabittir (Y4M için çift sayıya yuvarlanır)
+    bool start(const char* path, int width, int height, int framesPerSecond) {
+        y4m = strlen(path) > 4 && strcmp(path + strlen(path) - 4, ".y4m") == 0;
+        w = y4m ? width & ~1 : width;
+        h = y4m ? height & ~1 : height;
+        fps = glm::max(framesPerSecond, 1);
+        if (w <= 0 || h <= 0) return false;
+        if (y4m) {
+            out = fopen(path, "wb");
+            if (!out) return false;
+            fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", w, h, fps);
+            encoded.resize(static_cast<size_t>(w) * h * 3 / 2);
+        }
+        else {
+            prefix = path;
+            if (prefix.size() > 4 && prefix.compare(prefix.size() - 4, 4, ".png") == 0) prefix.resize(prefix.size() - 4);
+            // Sıkıştırmasız PNG: satır başına filtre baytı + RGB, 64 KB'lık saklı deflate blokları
+            size_t raw = static_cast<size_t>(h) * (w * 3 + 1);
+            encoded.resize(raw + (raw / 65535 + 1) * 5 + 128);
+        }
+
+        size_t bytes = static_cast<size_t>(w) * h * 4;
+        glGenBuffers(IN_FLIGHT, pbo);
+        for (GLuint b : pbo) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, b);
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        for (int i = 0; i < POOL; ++i) {
+            pool[i].resize(bytes);
+            freeList[freeCount++] = i;
+        }
+        stop = false;
+        encoder = std::thread(&FrameCapture::encodeLoop, this);
+        active = true;
+        return true;
+    }
+
+    // Kare sonunda, takastan önce: framebuffer'ın tamamını sıradaki PBO'ya okur, en eski PBO'yu kodlayıcıya verir
+    void grab(GLuint framebuffer) {
+        if (!active) return;
+        TRACE_SCOPE("capture grab");
+        int slot = static_cast<int>(issued % IN_FLIGHT);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[slot]);
+        glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ++issued;
+        if (issued - collected >= IN_FLIGHT) collect();
+    }
+
+    // Bekleyen PBO'ları boşaltır, kodlayıcının bitirmesini bekler ve dosyayı kapatır
+    void finish() {
+        if (!active) return;
+        while (collected < issued) collect();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        work.notify_one();
+        encoder.join();
+        if (out) fclose(out);
+        out = nullptr;
+        glDeleteBuffers(IN_FLIGHT, pbo);
+        active = false;
+        cout << "Capture: " << written << " frames (" << w << "x" << h << " @" << fps << "), waited for the encoder on " << waits << endl;
+    }
+
+    ~FrameCapture() { finish(); }
+
+private:
+    GLuint pbo[IN_FLIGHT];
+    GLsync fences[IN_FLIGHT];
+    size_t issued, collected;
+    vector<unsigned char> pool[POOL];
+    vector<unsigned char> encoded; // Yalnızca kodlayıcı iş parçacığında
+    FILE* out;
+    string prefix;
+    bool y4m, stop;
+    std::thread encoder;
+    std::mutex mutex;
+    std::condition_variable work, space;
+    int queue[POOL], freeList[POOL];
+    size_t queueHead, queueTail;
+    int freeCount;
+    size_t written;
+
+    void collect() {
+        int slot = static_cast<int>(collected % IN_FLIGHT);
+        if (fences[slot]) {
+            // IN_FLIGHT - 1 kare önce istenen kopya normalde çoktan bitmiştir; değilse bitmesini bekle
+            glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            glDeleteSync(fences[slot]);
+            fences[slot] = 0;
+        }
+        int buffer;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!freeCount) ++waits;
+            space.wait(lock, [this] { return freeCount > 0; });
+            buffer = freeList[--freeCount];
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[slot]);
+        if (void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pool[buffer].size(), GL_MAP_READ_BIT)) {
+            memcpy(pool[buffer].data(), pixels, pool[buffer].size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        ++collected;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue[queueTail++ % POOL] = buffer;
+        }
+        work.notify_one();
+        ++frames;
+    }
+
+    void encodeLoop() {
+        TRACE_THREAD("capture encoder");
+        for (;;) {
+            int buffer;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work.wait(lock, [this] { return stop || queueHead != queueTail; });
+                if (queueHead == queueTail) return; // Durduruldu ve kuyruk boş
+                buffer = queue[queueHead++ % POOL];
+            }
+            {
+                TRACE_SCOPE("encode frame");
+                if (y4m) writeY4M(pool[buffer].data());
+                else writePNG(pool[buffer].data());
+            }
+            ++written;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                freeList[freeCount++] = buffer;
+            }
+            space.notify_one();
+        }
+    }
+
+    // RGBA (alttan üste) -> BT.601 tam aralık YUV 4:2:0 (üstten alta); renk 2x2 bloğun ortalaması
+    void writeY4M(const unsigned char* rgba) {
+        unsigned char* Y = encoded.data(), *U = Y + w * h, *V = U + w * h / 4;
+        for (int y = 0; y < h; y += 2) {
+            const unsigned char* row0 = rgba + static_cast<size_t>(h - 1 - y) * w * 4, *row1 = row0 - w * 4;
+            for (int x = 0; x < w; x += 2) {
+                int r = 0, g = 0, b = 0;
+                for (int k = 0; k < 4; ++k) {
+                    const unsigned char* p = (k < 2 ? row0 : row1) + (x + (k & 1)) * 4;
+                    Y[(y + k / 2) * w + x + (k & 1)] = static_cast<unsigned char>((77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8);
+                    r += p[0]; g += p[1]; b += p[2];
+                }
+                U[(y / 2) * (w / 2) + x / 2] = static_cast<unsigned char>(((-43 * r - 85 * g + 128 * b) >> 10) + 128);
+                V[(y / 2) * (w / 2) + x / 2] = static_cast<unsigned char>(((128 * r - 107 * g - 21 * b) >> 10) + 128);
+            }
+        }
+        fputs("FRAME\n", out);
+        fwrite(encoded.data(), 1, encoded.size(), out);
+    }
+
+    static uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+        static uint32_t table[256];
+        if (!table[1]) for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    static unsigned char* be32(unsigned char* p, uint32_t v) {
+        p[0] = static_cast<unsigned char>(v >> 24); p[1] = static_cast<unsigned char>(v >> 16);
+        p[2] = static_cast<unsigned char>(v >> 8); p[3] = static_cast<unsigned char>(v);
+        return p + 4;
+    }
+
+    void chunk(FILE* f, const char* type, const unsigned char* data, uint32_t size) {
+        unsigned char head[8];
+        be32(head, size);
+        memcpy(head + 4, type, 4);
+        uint32_t crc = crc32(data, size, crc32(head + 4, 4));
+        fwrite(head, 1, 8, f);
+        fwrite(data, 1, size, f);
+        be32(head, crc);
+        fwrite(head, 1, 4, f);
+    }
+
+    // Sıkıştırmasız PNG: hızlı ve bağımlılıksız, boyut ham RGB kadar (sonradan ffmpeg/optipng ile küçültülür)
+    void writePNG(const unsigned char* rgba) {
+        char name[512];
+        snprintf(name, sizeof(name), "%s_%06zu.png", prefix.c_str(), written);
+        FILE* f = fopen(name, "wb");
+        if (!f) return;
+        static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        fwrite(signature, 1, 8, f);
+        unsigned char ihdr[13];
+        be32(be32(ihdr, w), h);
+        ihdr[8] = 8; ihdr[9] = 2; ihdr[10] = ihdr[11] = ihdr[12] = 0; // 8 bit RGB
+        chunk(f, "IHDR", ihdr, 13);
+
+        unsigned char* z = encoded.data();
+        *z++ = 0x78; *z++ = 0x01; // zlib başlığı, saklı bloklar
+        size_t rowBytes = static_cast<size_t>(w) * 3 + 1, total = rowBytes * h, done = 0, blockLeft = 0;
+        uint32_t a = 1, b = 0;
+        for (int y = 0; y < h; ++y) {
+            const unsigned char* src = rgba + static_cast<size_t>(h - 1 - y) * w * 4;
+            for (size_t i = 0; i < rowBytes; ++i) {
+                if (!blockLeft) {
+                    blockLeft = std::min<size_t>(65535, total - done);
+                    *z++ = done + blockLeft == total ? 1 : 0;
+                    *z++ = static_cast<unsigned char>(blockLeft); *z++ = static_cast<unsigned char>(blockLeft >> 8);
+                    *z++ = static_cast<unsigned char>(~blockLeft); *z++ = static_cast<unsigned char>(~blockLeft >> 8);
+                }
+                unsigned char v = i == 0 ? 0 : src[(i - 1) / 3 * 4 + (i - 1) % 3];
+                *z++ = v;
+                a = (a + v) % 65521; b = (b + a) % 65521;
+                --blockLeft; ++done;
+            }
+        }
+        z = be32(z, (b << 16) | a);
+        chunk(f, "IDAT", encoded.data(), static_cast<uint32_t>(z - encoded.data()));
+        chunk(f, "IEND", nullptr, 0);
+        fclose(f);
+    }
+};
+
+// Ekran uzayı dörtgenlerini biriktirir; katman ve doku sırasına dizip tek tampondan doku başına tek çizimle basar
+class UIBatch {
+public:
+    struct Quad {
+        const Texture* tex;
+        int layer;          // Farklı dokulu dörtgenler üst üste biniyorsa sırayı belirler
+        glm::vec4 rect;     // Merkez x, y ve genişlik, yükseklik (piksel, y yukarı)
+        glm::vec4 tint;
+    };
+
+    vector<Quad> quads;
+    vector<GLfloat> verts;  // Pozisyon (2) + Doku koordinatları (2) + Renk (4)
+    GLuint VAO;
+    size_t drawCalls;       // Son flush'taki çizim sayısı
+
+    UIBatch() : drawCalls(0) {
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glBindVertexArray(0);
+    }
+
+    void add(const Texture& tex, const glm::vec4& rect, const glm::vec4& tint = glm::vec4(1.0f), int layer = 0) {
+        Quad q = { &tex, layer, rect, tint };
+        quads.push_back(q);
+    }
+
+    void flush(Shader& shader, const glm::mat4& proj) {
+        drawCalls = 0;
+        if (quads.empty()) return;
+        // Kararlı eklemeli sıralama (stable_sort geçici tampon ayırır; birkaç düzine dörtgen için bu yeterli):
+        // aynı katman ve dokudaki dörtgenler eklenme sırasını korur
+        for (size_t i = 1; i < quads.size(); ++i) {
+            Quad q = quads[i];
+            size_t j = i;
+            while (j > 0 && (quads[j - 1].layer > q.layer || (quads[j - 1].layer == q.layer && quads[j - 1].tex->ID > q.tex->ID))) {
+                quads[j] = quads[j - 1];
+                --j;
+            }
+            quads[j] = q;
+        }
+        verts.clear();
+        for (const Quad& q : quads) {
+            float x0 = q.rect.x - q.rect.z / 2, x1 = q.rect.x + q.rect.z / 2;
+            float y0 = q.rect.y - q.rect.w / 2, y1 = q.rect.y + q.rect.w / 2;
+            const float corners[6][4] = { {x0,y0,0,0}, {x1,y0,1,0}, {x1,y1,1,1}, {x1,y1,1,1}, {x0,y1,0,1}, {x0,y0,0,0} };
+            for (const auto& c : corners) {
+                verts.insert(verts.end(), c, c + 4);
+                verts.insert(verts.end(), &q.tint.x, &q.tint.x + 4);
+            }
+        }
+
+        StreamBuffer& stream = StreamBuffer::current();
+        size_t offset = stream.upload(verts.data(), verts.size() * sizeof(GLfloat), 8 * sizeof(GLfloat));
+
+        shader.use();
+        shader.setMat4("projection", proj);
+        glUniform1i(glGetUniformLocation(shader.ID, "texture1"), 0);
+        glDisable(GL_DEPTH_TEST);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, stream.VBO);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)offset);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(offset + 2 * sizeof(GLfloat)));
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(offset + 4 * sizeof(GLfloat)));
+        size_t first = 0;
+        while (first < quads.size()) {
+            size_t last = first + 1;
+            while (last < quads.size() && quads[last].tex == quads[first].tex && quads[last].layer == quads[first].layer) ++last;
+            quads[first].tex->bind(GL_TEXTURE0);
+            glDrawArrays(GL_TRIANGLES, static_cast<GLint>(first * 6), static_cast<GLsizei>((last - first) * 6));
+            ++drawCalls;
+            first = last;
+        }
+        glBindVertexArray(0);
+        glEnable(GL_DEPTH_TEST);
+        quads.clear();
+    }
+
+    ~UIBatch() {
+        glDeleteVertexArrays(1, &VAO);
+    }
+};
+
+enum UIAction { UI_NONE, UI_PLAY, UI_SETTINGS, UI_QUIT, UI_MENU, UI_KEYBINDS, UI_FULLSCREEN, UI_WINDOWED, UI_EASY, UI_HARD, UI_SENSITIVITY };
+
+// Konum = anchor * pencere boyutu + offset, boyut = relSize * pencere boyutu + size
+struct Widget {
+    enum Kind { IMAGE, BUTTON, SLIDER };
+    Kind kind;
+    UIAction action;
+    const Texture* tex;     // IMAGE dokusu; BUTTON görünmezdir, yalnızca isabet bölgesi
+    glm::vec2 anchor, offset, relSize, size;
+    glm::vec4 tint;
+    int layer;
+    float value;            // SLIDER: 0..1
+    glm::vec4 rect;         // layout sonrası: merkez x, y, genişlik, yükseklik
+};
+
+// Bir ekranın kalıcı widget listesi. İsabet testi çizimsiz, CPU'daki dikdörtgenlerle ve kaba bir ızgarayla yapılır.
+class UIScreen {
+public:
+    enum { GRID = 8 };
+
+    vector<Widget> widgets;
+    vector<uint16_t> cells[GRID * GRID]; // Her hücreyle kesişen etkileşimli widget'lar, eklenme sırasıyla
+    int layoutW, layoutH;
+
+    UIScreen() : layoutW(0), layoutH(0) {}
+
+    size_t image(const Texture& tex, glm::vec2 anchor, glm::vec2 offset, glm::vec2 relSize, glm::vec2 size, int layer = 0) {
+        return add(Widget::IMAGE, UI_NONE, &tex, anchor, offset, relSize, size, layer);
+    }
+    size_t background(const Texture& tex) { return image(tex, glm::vec2(0.5f), glm::vec2(0.0f), glm::vec2(1.0f), glm::vec2(0.0f)); }
+    size_t button(UIAction action, glm::vec2 anchor, glm::vec2 offset, glm::vec2 size) {
+        return add(Widget::BUTTON, action, nullptr, anchor, offset, glm::vec2(0.0f), size, 0);
+    }
+    size_t slider(UIAction action, glm::vec2 anchor, glm::vec2 offset, glm::vec2 size, int layer) {
+        return add(Widget::SLIDER, action, nullptr, anchor, offset, glm::vec2(0.0f), size, layer);
+    }
+
+    // Pencere boyutu değiştiyse dikdörtgenleri ve ızgarayı yeniden kurar
+    void layout(int w, int h) {
+        if (w == layoutW && h == layoutH) return;
+        layoutW = w; layoutH = h;
+        for (auto& c : cells) c.clear();
+        glm::vec2 win(static_cast<float>(w), static_cast<float>(h));
+        for (size_t i = 0; i < widgets.size(); ++i) {
+            Widget& wd = widgets[i];
+            glm::vec2 c = wd.anchor * win + wd.offset, sz = wd.relSize * win + wd.size;
+            wd.rect = glm::vec4(c.x, c.y, sz.x, sz.y);
+            if (wd.kind == Widget::IMAGE) continue;
+            glm::ivec2 lo = cellOf(c.x - sz.x / 2, c.y - sz.y / 2), hi = cellOf(c.x + sz.x / 2, c.y + sz.y / 2);
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x) cells[y * GRID + x].push_back(static_cast<uint16_t>(i));
+        }
+    }
+
+    // En üstteki (son eklenen) etkileşimli widget; yoksa -1
+    int hit(float x, float y) const {
+        if (x < 0 || y < 0 || x >= layoutW || y >= layoutH) return -1;
+        glm::ivec2 c = cellOf(x, y);
+        const vector<uint16_t>& list = cells[c.y * GRID + c.x];
+        for (size_t i = list.size(); i-- > 0;) {
+            const glm::vec4& r = widgets[list[i]].rect;
+            if (x >= r.x - r.z / 2 && x <= r.x + r.z / 2 && y >= r.y - r.w / 2 && y <= r.y + r.w / 2) return list[i];
+        }
+        return -1;
+    }
+
+    void draw(UIBatch& batch, const Texture& white) const {
+        for (const Widget& wd : widgets) {
+            if (wd.kind == Widget::IMAGE && wd.tex) batch.add(*wd.tex, wd.rect, wd.tint, wd.layer);
+            else if (wd.kind == Widget::SLIDER) {
+                batch.add(white, wd.rect, glm::vec4(0.5f, 0.5f, 0.5f, 1.0f), wd.layer);
+                float handleX = wd.rect.x - wd.rect.z / 2 + wd.value * wd.rect.z - wd.rect.w / 2;
+                batch.add(white, glm::vec4(handleX, wd.rect.y, wd.rect.w, wd.rect.w), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), wd.layer);
+            }
+        }
+    }
+
+private:
+    size_t add(Widget::Kind kind, UIAction action, const Texture* tex, glm::vec2 anchor, glm::vec2 offset, glm::vec2 relSize, glm::vec2 size, int layer) {
+        Widget wd;
+        wd.kind = kind; wd.action = action; wd.tex = tex;
+        wd.anchor = anchor; wd.offset = offset; wd.relSize = relSize; wd.size = size;
+        wd.tint = glm::vec4(1.0f); wd.layer = layer; wd.value = 0.0f; wd.rect = glm::vec4(0.0f);
+        widgets.push_back(wd);
+        layoutW = layoutH = 0;
+        return widgets.size() - 1;
+    }
+
+    glm::ivec2 cellOf(float x, float y) const {
+        int cx = static_cast<int>(x * GRID / std::max(layoutW, 1)), cy = static_cast<int>(y * GRID / std::max(layoutH, 1));
+        return glm::ivec2(glm::clamp(cx, 0, GRID - 1), glm::clamp(cy, 0, GRID - 1));
+    }
+};
+
+// fonts/*.sdf: --bake-font'un yazdığı işaretli uzaklık alanı (SDF) atlası. Başlık, 128 ASCII glif kaydı ve R8 atlas
+// pikselleri art arda; tüm alanlar 4 bayt, küçük uçlu. Glif ölçüleri pixelSize'daki piksel cinsinden (y yukarı)
+struct FontFileHeader {
+    char magic[4];              // "SDFF"
+    uint32_t version, atlasW, atlasH, glyphCount;
+    float pixelSize, spread;    // spread: 0..1 aralığının kapsadığı uzaklık (± piksel)
+};
+
+struct FontGlyph {
+    float u0, v0, u1, v1;       // Atlas koordinatları (v0 üst)
+    float x0, y0, x1, y1;       // Kalem konumuna göre dörtgen (dolgu dahil)
+    float advance;
+};
+
+// Atlas eşlenmiş dosyadan doğrudan yüklenir; FreeType yalnızca --bake-font aracında kullanılır.
+// Glifler tek atlastan, dizge başına tek çizimle basılır; SDF sayesinde her ölçekte keskin
+class TextRenderer {
+public:
+    enum { BATCH = 128, FONT_VERSION = 1 };
+
+    MappedFile file;            // Paket yoksa atlas dosyası ayrıca eşlenir
+    AssetPack::View font;
+    const FontFileHeader* header;
+    const FontGlyph* glyphs;    // Eşlenmiş dosyanın içinde, kopyalanmaz
+    Shader* shader;
+    GLuint VAO, atlas;
+    GLfloat verts[BATCH * 6 * 4]; // Parti burada birikir, StreamBuffer'a tek kopyayla gider
+
+    TextRenderer(Shader* s, const char* path = "fonts/ui.sdf") : header(nullptr), glyphs(nullptr), shader(s), atlas(0) {
+        if (!AssetPack::current().find(path, font)) {
+            font.data = file.open(path) ? file.data : nullptr;
+            font.size = file.size;
+        }
+        if (!font.data || !validate()) {
+            std::cerr << "Font " << path << " missing or invalid; bake it with --bake-font <file.ttf>" << std::endl;
+            file.close();
+        }
+        else {
+            header = reinterpret_cast<const FontFileHeader*>(font.data);
+            glyphs = reinterpret_cast<const FontGlyph*>(font.data + sizeof(FontFileHeader));
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glGenTextures(1, &atlas);
+            glBindTexture(GL_TEXTURE_2D, atlas);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, header->atlasW, header->atlasH, 0, GL_RED, GL_UNSIGNED_BYTE, glyphs + header->glyphCount);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+    }
+
+    bool validate() const {
+        if (font.size < sizeof(FontFileHeader)) return false;
+        const FontFileHeader* h = reinterpret_cast<const FontFileHeader*>(font.data);
+        return memcmp(h->magic, "SDFF", 4) == 0 && h->version == FONT_VERSION && h->glyphCount == 128 &&
+            font.size >= sizeof(FontFileHeader) + h->glyphCount * sizeof(FontGlyph) + static_cast<size_t>(h->atlasW) * h->atlasH;
+    }
+
+    // scale 1 = pixelSize (48 px) yüksekliğinde metin
+    void draw(const char* text, float x, float y, float scale, glm::vec3 color) {
+        if (!glyphs) return;
+        TRACE_SCOPE("text");
+        shader->use();
+        glUniform3f(glGetUniformLocation(shader->ID, "textColor"), color.x, color.y, color.z);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        glBindVertexArray(VAO);
+        StreamBuffer& stream = StreamBuffer::current();
+
+        int count = 0;
+        for (const char* p = text; ; ++p) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (count == BATCH || (!c && count)) {
+                size_t offset = stream.upload(verts, count * 6 * 4 * sizeof(GLfloat));
+                glBindBuffer(GL_ARRAY_BUFFER, stream.VBO);
+                glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)offset);
+                glDrawArrays(GL_TRIANGLES, 0, count * 6);
+                count = 0;
+            }
+            if (!c) break;
+            if (c >= 128) continue;
+            const FontGlyph& g = glyphs[c];
+            GLfloat x0 = x + g.x0 * scale, x1 = x + g.x1 * scale, y0 = y + g.y0 * scale, y1 = y + g.y1 * scale;
+            GLfloat quad[6][4] = {
+                { x0, y1, g.u0, g.v0 }, { x0, y0, g.u0, g.v1 }, { x1, y0, g.u1, g.v1 },
+                { x0, y1, g.u0, g.v0 }, { x1, y0, g.u1, g.v1 }, { x1, y1, g.u1, g.v0 }
+            };
+            if (g.x1 > g.x0) memcpy(verts + count++ * 6 * 4, quad, sizeof(quad));
+            x += g.advance * scale;
+        }
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Çevrimdışı araç: TTF'yi supersample x büyüklükte tarar, her atlas pikseli için ±spread içindeki en yakın
+    // karşıt piksele uzaklığı bulur ve 0.5 = kenar olacak şekilde 8 bite yazar
+    static int bake(const char* ttfPath, const char* outPath, int pixelSize) {
+        const int supersample = 4, spread = glm::max(pixelSize / 8, 2), atlasW = 512;
+        FT_Library ft;
+        FT_Face face;
+        if (FT_Init_FreeType(&ft) || FT_New_Face(ft, ttfPath, 0, &face)) {
+            std::cerr << "Cannot open font " << ttfPath << std::endl;
+            return 1;
+        }
+        FT_Set_Pixel_Sizes(face, 0, pixelSize * supersample);
+
+        vector<FontGlyph> out(128);
+        vector<vector<unsigned char>> bitmaps(128);
+        vector<glm::ivec2> sizes(128, glm::ivec2(0)), places(128, glm::ivec2(0));
+        int penX = 1, penY = 1, rowH = 0;
+        for (int c = 0; c < 128; ++c) {
+            FontGlyph& g = out[c];
+            memset(&g, 0, sizeof(g));
+            if (FT_Load_Char(face, c, FT_LOAD_RENDER)) continue;
+            const FT_Bitmap& bm = face->glyph->bitmap;
+            g.advance = face->glyph->advance.x / 64.0f / supersample;
+            if (c < 32 || c == 127 || bm.width == 0 || bm.rows == 0) continue;
+
+            // Yüksek çözünürlüklü maske, atlas pikseline denk gelecek şekilde supersample katına dolgulanır
+            int pad = spread * supersample;
+            int w = (static_cast<int>(bm.width) + 2 * pad + supersample - 1) / supersample, h = (static_cast<int>(bm.rows) + 2 * pad + supersample - 1) / supersample;
+            int hiW = w * supersample, hiH = h * supersample;
+            vector<unsigned char> inside(hiW * hiH, 0);
+            for (unsigned y = 0; y < bm.rows; ++y)
+                for (unsigned x = 0; x < bm.width; ++x)
+                    inside[(y + pad) * hiW + x + pad] = bm.buffer[y * bm.pitch + x] >= 128;
+
+            vector<unsigned char>& px = bitmaps[c];
+            px.resize(w * h);
+            float maxDist = static_cast<float>(pad);
+            for (int oy = 0; oy < h; ++oy) {
+                for (int ox = 0; ox < w; ++ox) {
+                    int cx = ox * supersample + supersample / 2, cy = oy * supersample + supersample / 2;
+                    bool in = inside[cy * hiW + cx] != 0;
+                    float best = maxDist * maxDist;
+                    for (int dy = -pad; dy <= pad; ++dy) {
+                        int y = cy + dy;
+                        if (y < 0 || y >= hiH || dy * dy >= best) continue;
+                        for (int dx = -pad; dx <= pad; ++dx) {
+                            int x = cx + dx;
+                            if (x < 0 || x >= hiW || (inside[y * hiW + x] != 0) == in) continue;
+                            best = std::min(best, static_cast<float>(dx * dx + dy * dy));
+                        }
+                    }
+                    float d = (sqrt(best) - 0.5f) / supersample; // Atlas pikseli cinsinden kenara uzaklık
+                    float v = 0.5f + (in ? d : -d) / (2.0f * spread);
+                    px[oy * w + ox] = static_cast<unsigned char>(glm::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+
+            if (penX + w + 1 > atlasW) { penX = 1; penY += rowH + 1; rowH = 0; }
+            sizes[c] = glm::ivec2(w, h);
+            places[c] = glm::ivec2(penX, penY);
+            penX += w + 1;
+            rowH = std::max(rowH, h);
+            float left = static_cast<float>(face->glyph->bitmap_left - pad) / supersample, top = static_cast<float>(face->glyph->bitmap_top + pad) / supersample;
+            g.x0 = left; g.x1 = left + w;
+            g.y1 = top; g.y0 = top - h;
+        }
+        FT_Done_Face(face);
+        FT_Done_FreeType(ft);
+
+        int atlasH = (penY + rowH + 1 + 3) & ~3;
+        vector<unsigned char> atlasPixels(atlasW * atlasH, 0);
+        for (int c = 0; c < 128; ++c) {
+            if (!sizes[c].x) continue;
+            for (int y = 0; y < sizes[c].y; ++y)
+                memcpy(&atlasPixels[(places[c].y + y) * atlasW + places[c].x], &bitmaps[c][y * sizes[c].x], sizes[c].x);
+            FontGlyph& g = out[c];
+            g.u0 = static_cast<float>(places[c].x) / atlasW; g.u1 = static_cast<float>(places[c].x + sizes[c].x) / atlasW;
+            g.v0 = static_cast<float>(places[c].y) / atlasH; g.v1 = static_cast<float>(places[c].y + sizes[c].y) / atlasH;
+        }
+
+        FontFileHeader header;
+        memcpy(header.magic, "SDFF", 4);
+        header.version = FONT_VERSION;
+        header.atlasW = atlasW; header.atlasH = atlasH; header.glyphCount = 128;
+        header.pixelSize = static_cast<float>(pixelSize); header.spread = static_cast<float>(spread);
+        FILE* f = fopen(outPath, "wb");
+        if (!f) { std::cerr << "Cannot write " << outPath << std::endl; return 1; }
+        fwrite(&header, sizeof(header), 1, f);
+        fwrite(out.data(), sizeof(FontGlyph), out.size(), f);
+        fwrite(atlasPixels.data(), 1, atlasPixels.size(), f);
+        fclose(f);
+        std::cout << "Baked " << ttfPath << " -> " << outPath << " (" << atlasW << "x" << atlasH << " atlas, " << pixelSize << " px, spread " << spread << ")" << std::endl;
+        return 0;
+    }
+
+    ~TextRenderer() {
+        glDeleteVertexArrays(1, &VAO);
+        if (atlas) glDeleteTextures(1, &atlas);
+    }
+};
+
+// Bir simülasyon adımının girdisi: klavyeden, ağdan ya da bottan gelebilir
+struct PlayerInput {
+    glm::vec3 front; // Kamera bakış yönü (hareket ve dash buna göre)
+    float time;      // Girdinin zamanı (saniye)
+    bool forward, back, left, right, jump, superJump, dash;
+
+    PlayerInput() : front(0.0f, 0.0f, -1.0f), time(0.0f), forward(false), back(false), left(false), right(false), jump(false), superJump(false), dash(false) {}
+
+    static PlayerInput fromKeys(const bool* keys, const glm::vec3& front, float time) {
+        PlayerInput in;
+        in.front = front;
+        in.time = time;
+        in.forward = keys[GLFW_KEY_W];
+        in.back = keys[GLFW_KEY_S];
+        in.left = keys[GLFW_KEY_A];
+        in.right = keys[GLFW_KEY_D];
+        in.jump = keys[GLFW_KEY_SPACE];
+        in.superJump = keys[GLFW_KEY_Q];
+        in.dash = keys[GLFW_KEY_E];
+        return in;
+    }
+
+    static bool isPlayerKey(int key) {
+        return key == GLFW_KEY_W || key == GLFW_KEY_S || key == GLFW_KEY_A || key == GLFW_KEY_D ||
+            key == GLFW_KEY_SPACE || key == GLFW_KEY_Q || key == GLFW_KEY_E;
+    }
+};
+
+// Tek üretici / tek tüketici kilitsiz halka
+template<typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    bool push(const T& v) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) return false; // Dolu
+        items[h & (N - 1)] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        out = items[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[N];
+    std::atomic<size_t> head, tail;
+};
+
+enum InputKind : uint8_t { INPUT_KEY, INPUT_BUTTON };
+
+struct InputEvent {
+    double time;   // Olayın alındığı an (glfwGetTime)
+    double x, y;   // O andaki imleç konumu (pencere koordinatı, y aşağı)
+    int16_t code;  // Tuş ya da fare düğmesi, tüketilmiş tıklamada -1
+    uint8_t kind, action;
+};
+
+// GLFW geri çağrıları zaman damgalı olayları halkaya yazar; oyun her karede hepsini sırayla tüketir.
+// İki yoklama arasında basılıp bırakılan tuşlar da kaybolmaz.
+class InputQueue {
+public:
+    SpscRing<InputEvent, 1024> ring;
+    std::vector<InputEvent> frame;     // Bu karede tüketilen olaylar (zaman sıralı)
+    bool keyDown[GLFW_KEY_LAST + 1], frameStartKeys[GLFW_KEY_LAST + 1];
+    uint8_t keyPresses[GLFW_KEY_LAST + 1];
+    bool buttonDown[GLFW_MOUSE_BUTTON_LAST + 1];
+    double mouseX, mouseY;             // Karenin sonundaki imleç
+    double cursorX, cursorY;           // Geri çağrıların gördüğü son imleç; düğme olaylarına iliştirilir
+    size_t overflow;
+
+    InputQueue() : mouseX(0.0), mouseY(0.0), cursorX(0.0), cursorY(0.0), overflow(0) {
+        memset(keyDown, 0, sizeof(keyDown));
+        memset(frameStartKeys, 0, sizeof(frameStartKeys));
+        memset(keyPresses, 0, sizeof(keyPresses));
+        memset(buttonDown, 0, sizeof(buttonDown));
+        frame.reserve(256);
+    }
+
+    void attach(GLFWwindow* window) {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetKeyCallback(window, onKey);
+        glfwSetMouseButtonCallback(window, onButton);
+        glfwSetCursorPosCallback(window, onCursor);
+        glfwGetCursorPos(window, &cursorX, &cursorY);
+        mouseX = cursorX; mouseY = cursorY;
+    }
+
+    // Halkayı boşaltır ve tuş/düğme durumlarını karenin sonuna taşır
+    void beginFrame() {
+        memcpy(frameStartKeys, keyDown, sizeof(keyDown));
+        memset(keyPresses, 0, sizeof(keyPresses));
+        frame.clear();
+        InputEvent e;
+        while (ring.pop(e)) {
+            frame.push_back(e);
+            if (e.kind == INPUT_KEY) {
+                keyDown[e.code] = e.action == GLFW_PRESS;
+                if (e.action == GLFW_PRESS && keyPresses[e.code] < 255) ++keyPresses[e.code];
+            }
+            else buttonDown[e.code] = e.action == GLFW_PRESS;
+        }
+        // İmleç hareketleri kuyruğa girmez (1000 Hz farede halkayı doldurur); GLFW geri çağrıları
+        // glfwPollEvents içinde ana iş parçacığında çalıştığından son konumu doğrudan okumak güvenli
+        mouseX = cursorX; mouseY = cursorY;
+        if (overflow) {
+            cout << "Input queue overflow, dropped " << overflow << " events" << endl;
+            overflow = 0;
+        }
+    }
+
+    bool held(int key) const { return keyDown[key]; }
+    bool pressed(int key) const { return keyPresses[key] > 0; }
+    bool buttonHeld(int button) const { return buttonDown[button]; }
+
+    bool buttonPressed(int button) const {
+        for (const InputEvent& e : frame)
+            if (e.kind == INPUT_BUTTON && e.code == button && e.action == GLFW_PRESS) return true;
+        return false;
+    }
+
+    // Bu karedeki sıradaki sol tıklamayı tüketir; konum basış anındaki imleçtir (y yukarı)
+    bool popClick(int winH, float& x, float& y) {
+        for (InputEvent& e : frame) {
+            if (e.kind != INPUT_BUTTON || e.code != GLFW_MOUSE_BUTTON_LEFT || e.action != GLFW_PRESS) continue;
+            e.code = -1;
+            x = static_cast<float>(e.x);
+            y = static_cast<float>(winH - e.y);
+            return true;
+        }
+        return false;
+    }
+
+    // Karenin tamamı için tek girdi (sabit adımlı istemci için): basılı ya da bu karede basılmış
+    PlayerInput playerInput(const glm::vec3& front, float time) const {
+        PlayerInput in = PlayerInput::fromKeys(keyDown, front, time);
+        in.jump = in.jump || pressed(GLFW_KEY_SPACE);
+        in.superJump = in.superJump || pressed(GLFW_KEY_Q);
+        in.dash = in.dash || pressed(GLFW_KEY_E);
+        return in;
+    }
+
+    // [from, to] aralığını oyuncu tuşu olaylarının zamanlarında dilimleyip step(girdi, dt) çağırır.
+    // Bir basış, aynı anda bırakılmış olsa bile en az bir (dt = 0 olabilen) adımda görülür.
+    template<typename F>
+    void replay(double from, double to, const glm::vec3& front, F&& step) const {
+        bool keys[GLFW_KEY_LAST + 1];
+        memcpy(keys, frameStartKeys, sizeof(keys));
+        double t = from;
+        bool pendingPress = false;
+        for (const InputEvent& e : frame) {
+            if (e.kind != INPUT_KEY || !PlayerInput::isPlayerKey(e.code)) continue;
+            double et = glm::clamp(e.time, t, to);
+            if (et > t || pendingPress) {
+                step(PlayerInput::fromKeys(keys, front, static_cast<float>(t)), static_cast<float>(et - t));
+                pendingPress = false;
+            }
+            t = et;
+            keys[e.code] = e.action == GLFW_PRESS;
+            if (e.action == GLFW_PRESS) pendingPress = true;
+        }
+        if (to > t || pendingPress) step(PlayerInput::fromKeys(keys, front, static_cast<float>(t)), static_cast<float>(to - t));
+    }
+
+private:
+    void emit(uint8_t kind, int code, int action) {
+        InputEvent e;
+        e.time = glfwGetTime();
+        e.x = cursorX; e.y = cursorY;
+        e.code = static_cast<int16_t>(code);
+        e.kind = kind;
+        e.action = static_cast<uint8_t>(action);
+        if (!ring.push(e)) ++overflow;
+    }
+
+    static InputQueue* from(GLFWwindow* window) { return static_cast<InputQueue*>(glfwGetWindowUserPointer(window)); }
+
+    static void onKey(GLFWwindow* window, int key, int, int action, int) {
+        if (key < 0 || key > GLFW_KEY_LAST || action == GLFW_REPEAT) return;
+        from(window)->emit(INPUT_KEY, key, action);
+    }
+    static void onButton(GLFWwindow* window, int button, int action, int) {
+        if (button < 0 || button > GLFW_MOUSE_BUTTON_LAST) return;
+        from(window)->emit(INPUT_BUTTON, button, action);
+    }
+    static void onCursor(GLFWwindow* window, double x, double y) {
+        InputQueue* q = from(window);
+        q->cursorX = x; q->cursorY = y;
+    }
+};
+
+// Girdiden ekrana gecikme: olayın geliş anından, onu işleyen karenin GPU'da tamamlanmasına kadar.
+// Swap'ın önüne ve arkasına GL_TIMESTAMP sorgusu, arkasına da bir fence konur; fence düşünce
+// sorgular bekletmeden okunur. GPU saati glfwGetTime'a periyodik olarak hizalanır.
+class LatencyMonitor {
+public:
+    enum { IN_FLIGHT = 4, SAMPLES = 512 };
+
+    struct Frame {
+        GLuint queries[2];          // Swap öncesi (çizim bitti) / sonrası (sunum komutları bitti)
+        GLsync fence;
+        double sampleTime;          // Simülasyonun girdileri okuduğu an
+        double submitTime;          // Swap çağrıldığı an
+        vector<double> inputs;      // Bu karede tüketilen tuş/düğme olaylarının geliş anları
+        bool pending;
+    };
+
+    // Sabit boyutlu örnek halkası; yüzdelikler rapor anında hesaplanır
+    struct Samples {
+        float v[SAMPLES];
+        size_t count, head;
+        Samples() : count(0), head(0) {}
+        void add(float x) { v[head] = x; head = (head + 1) % SAMPLES; if (count < SAMPLES) ++count; }
+        float percentile(float p) const {
+            if (!count) return 0.0f;
+            float tmp[SAMPLES];
+            std::copy(v, v + count, tmp);
+            size_t k = std::min(count - 1, static_cast<size_t>(p * count));
+            std::nth_element(tmp, tmp + k, tmp + count);
+            return tmp[k];
+        }
+        float mean() const {
+            float sum = 0.0f;
+            for (size_t i = 0; i < count; ++i) sum += v[i];
+            return count ? sum / count : 0.0f;
+        }
+    };
+
+    Frame frames[IN_FLIGHT];
+    size_t current;
+    double gpuOffset, lastOverlay, lastLog;
+    Samples total, wait, cpu, gpu, present, frameLatency; // ms
+    char overlay[192];
+
+    LatencyMonitor() : current(0), gpuOffset(0.0), lastOverlay(0.0), lastLog(0.0) {
+        overlay[0] = '\0';
+        for (auto& f : frames) { f.queries[0] = f.queries[1] = 0; f.fence = 0; f.sampleTime = f.submitTime = 0.0; f.pending = false; }
+    }
+
+    void init() {
+        for (auto& f : frames) glGenQueries(2, f.queries);
+        calibrate();
+    }
+
+    void calibrate() {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuOffset = glfwGetTime() - gpuNow * 1e-9;
+    }
+
+    // Kare başında: biten kareleri topla, bu karenin girdilerini kaydet
+    void beginFrame(const InputQueue& input, double sampleTime) {
+        resolve(false);
+        Frame& f = frames[current];
+        if (f.pending) {
+            resolveFrame(f, true); // GPU IN_FLIGHT kare geride; beklemek zorundayız
+            if (f.pending) { glDeleteSync(f.fence); f.fence = 0; f.pending = false; } // Zaman aşımı: örneği at
+        }
+        f.sampleTime = sampleTime;
+        f.inputs.clear();
+        for (const InputEvent& e : input.frame) f.inputs.push_back(e.time);
+    }
+
+    void beforeSwap() {
+        Frame& f = frames[current];
+        glQueryCounter(f.queries[0], GL_TIMESTAMP);
+        f.submitTime = glfwGetTime();
+    }
+
+    void afterSwap() {
+        Frame& f = frames[current];
+        glQueryCounter(f.queries[1], GL_TIMESTAMP);
+        f.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        f.pending = true;
+        current = (current + 1) % IN_FLIGHT;
+    }
+
+    // Yüzdelikleri yarım saniyede bir metne döker; log açıksa 5 saniyede bir yazdırır
+    void report(double now, bool log) {
+        if (now - lastOverlay >= 0.5) {
+            lastOverlay = now;
+            snprintf(overlay, sizeof(overlay), "input->gpu p50 %.1f p95 %.1f p99 %.1f ms (wait %.1f cpu %.1f gpu %.1f, present +%.1f) | frame p50 %.1f",
+                total.percentile(0.5f), total.percentile(0.95f), total.percentile(0.99f), wait.mean(), cpu.mean(), gpu.mean(), present.mean(), frameLatency.percentile(0.5f));
+        }
+        if (now - lastLog >= 5.0) {
+            lastLog = now;
+            calibrate(); // GPU ve CPU saatleri zamanla kayar
+            if (log) cout << "Latency " << overlay << " [" << total.count << " inputs]" << endl;
+        }
+    }
+
+    ~LatencyMonitor() {
+        for (auto& f : frames) {
+            if (f.fence) glDeleteSync(f.fence);
+            if (f.queries[0]) glDeleteQueries(2, f.queries);
+        }
+    }
+
+private:
+    void resolve(bool block) {
+        for (auto& f : frames)
+            if (f.pending) resolveFrame(f, block);
+    }
+
+    void resolveFrame(Frame& f, bool block) {
+        GLenum r = glClientWaitSync(f.fence, block ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, block ? 100000000 : 0);
+        if (r != GL_ALREADY_SIGNALED && r != GL_CONDITION_SATISFIED) return;
+        GLuint64 drawn = 0, presented = 0;
+        glGetQueryObjectui64v(f.queries[0], GL_QUERY_RESULT, &drawn);
+        glGetQueryObjectui64v(f.queries[1], GL_QUERY_RESULT, &presented);
+        double drawnAt = drawn * 1e-9 + gpuOffset;
+        double presentedAt = presented * 1e-9 + gpuOffset;
+        for (double t : f.inputs) {
+            total.add(static_cast<float>((drawnAt - t) * 1000.0));
+            wait.add(static_cast<float>((f.sampleTime - t) * 1000.0));
+        }
+        cpu.add(static_cast<float>((f.submitTime - f.sampleTime) * 1000.0));
+        gpu.add(static_cast<float>((drawnAt - f.submitTime) * 1000.0));
+        present.add(static_cast<float>((presentedAt - drawnAt) * 1000.0));
+        frameLatency.add(static_cast<float>((drawnAt - f.sampleTime) * 1000.0));
+        glDeleteSync(f.fence);
+        f.fence = 0;
+        f.pending = false;
+    }
+};
+
+// Oyuncunun değişken simülasyon durumu: düz veri, memcpy ile kaydedilip geri yüklenir
+struct PlayerState {
+    glm::vec3 pos, rollDir, lastValidRollDir;
+    float rollTime, jumpVel, dashTime, dashCool, superJumpCool, lastMoveTime;
+    bool rolling, jumping, dashing, waveTriggered, superJumpUsed, isMoving, enableAbilities;
+};
+
+struct PlayerTuning {
+    const float speed = 3.0f, rollDur = 1.0f, gravity = 9.8f, jumpPower = 4.0f, superJumpPower = 10.0f, dashDur = 0.2f, dashSpeed = 12.0f, maxDashCool = 8.0f, maxSuperJumpCool = 15.0f, stopRollDur = 0.2f;
+};
+
+class Player : public PlayerState, public PlayerTuning {
+public:
+    Transform xf; // Çizim matrisi önbelleği, simülasyon durumunun parçası değil
+
+    Player(glm::vec3 startPos = glm::vec3(0.0f), bool enableAbilities = true) : PlayerState(initialState(startPos, enableAbilities)) {}
+
+    static PlayerState initialState(glm::vec3 startPos, bool enableAbilities) {
+        PlayerState s;
+        s.pos = startPos;
+        s.rollDir = s.lastValidRollDir = glm::vec3(0.0f);
+        s.rollTime = s.jumpVel = s.dashTime = s.dashCool = s.superJumpCool = s.lastMoveTime = 0.0f;
+        s.rolling = s.jumping = s.dashing = s.waveTriggered = s.superJumpUsed = s.isMoving = false;
+        s.enableAbilities = enableAbilities;
+        return s;
+    }
+
+    PlayerState& state() { return *this; }
+    const PlayerState& state() const { return *this; }
+
+    void reset(glm::vec3 startPos) { state() = initialState(startPos, enableAbilities); }
+
+    void update(const PlayerInput& in, float dt) {
+        TRACE_SCOPE("Player::update");
+        glm::vec3 dir(0.0f);
+        glm::vec3 right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), in.front));
+        bool movingNow = false;
+
+        if (in.forward) { dir += in.front; movingNow = true; }
+        if (in.back) { dir -= in.front; movingNow = true; }
+        if (in.left) { dir += right; movingNow = true; }
+        if (in.right) { dir -= right; movingNow = true; }
+
+        if (movingNow != isMoving) {
+            isMoving = movingNow;
+            if (isMoving) {
+                rolling = true;
+                rollTime = 0.0f;
+                dir.y = 0.0f;
+                if (glm::length(dir) > 0.001f) {
+                    rollDir = glm::normalize(dir);
+                }
+            }
+            lastMoveTime = in.time;
+        }
+
+        if (isMoving && (!dashing || !enableAbilities)) {
+            dir.y = 0.0f;
+            if (glm::length(dir) > 0.001f) {
+                dir = glm::normalize(dir);
+                float turnSpeed = 10.0f * dt;
+                rollDir = glm::mix(rollDir, dir, turnSpeed);
+                if (glm::length(rollDir) > 0.9f) {
+                    lastValidRollDir = rollDir;
+                }
+                // Duvara ya da sütuna çarptıysa pozisyonu sınırda tut
+                pos = ArenaMap::current().push(pos + dir * speed * dt, ArenaMap::bodyRadius);
+
+                rollTime += dt;
+                if (rollTime > rollDur) {
+                    rollTime = fmod(rollTime, rollDur);
+                }
+            }
+        }
+        else if (rolling) {
+            rollTime += dt;
+            if (rollTime >= stopRollDur) {
+                rolling = false;
+                rollTime = 0.0f;
+            }
+        }
+
+        if (enableAbilities && dashing) {
+            dashTime += dt;
+            if (dashTime >= dashDur) {
+                dashing = false;
+                dashTime = 0.0f;
+                dashCool = maxDashCool;
+            }
+            else {
+                glm::vec3 dashDir = glm::normalize(glm::vec3(in.front.x, 0.0f, in.front.z));
+                pos = ArenaMap::current().push(pos + dashDir * speed * dashSpeed * dt, ArenaMap::bodyRadius);
+            }
+        }
+
+        if (in.jump && !jumping) {
+            jumping = true;
+            jumpVel = jumpPower;
+        }
+
+        if (enableAbilities && in.superJump && !jumping && superJumpCool <= 0.0f) {
+            jumping = true;
+            jumpVel = superJumpPower;
+            superJumpCool = maxSuperJumpCool;
+            superJumpUsed = true;
+        }
+
+        if (jumping) {
+            pos.y += jumpVel * dt;
+            jumpVel -= gravity * dt;
+            if (pos.y <= 0.5f) {
+                pos.y = 0.5f;
+                jumping = false;
+                jumpVel = 0.0f;
+                if (enableAbilities && superJumpUsed) {
+                    waveTriggered = true;
+                    superJumpUsed = false;
+                }
+            }
+        }
+
+        if (enableAbilities && in.dash && !dashing && !rolling && dashCool <= 0.0f) {
+            dashing = true;
+            dashTime = 0.0f;
+        }
+
+        if (enableAbilities && dashCool > 0.0f) dashCool -= dt;
+        if (dashCool < 0.0f) dashCool = 0.0f;
+
+        if (enableAbilities && superJumpCool > 0.0f) superJumpCool -= dt;
+        if (superJumpCool < 0.0f) superJumpCool = 0.0f;
+    }
+
+    // Konum ve yuvarlanma dönüşü; matris yalnızca biri değiştiğinde yeniden kurulur
+    const glm::mat4& getModel() {
+        xf.setPosition(pos);
+        if (rolling) {
+            float progress = rollTime / rollDur;
+            glm::vec3 axis = glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), lastValidRollDir);
+            if (glm::length(axis) < 0.1f) {
+                axis = glm::vec3(1.0f, 0.0f, 0.0f);
+            }
+            xf.setRotation(glm::radians(360.0f * progress), glm::normalize(axis));
+        }
+        else xf.setRotation(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
+        return xf.world();
+    }
+
+    float getDashCool() const { return dashCool; }
+    float getSuperJumpCool() const { return superJumpCool; }
+    bool getWaveTriggered() const { return waveTriggered; }
+    void resetWave() { waveTriggered = false; }
+};
+
+struct WaveState {
+    glm::vec3 center;
+    float radius;
+    bool active;
+};
+
+class Wave : public WaveState {
+public:
+    const float maxRadius = 5.0f;
+    const float growSpeed = 5.0f;
+
+    Transform xf;
+
+    Wave() { center = glm::vec3(0.0f); radius = 0.0f; active = false; }
+
+    WaveState& state() { return *this; }
+    const WaveState& state() const { return *this; }
+
+    void update(float dt) {
+        if (active) {
+            radius += growSpeed * dt;
+            if (radius >= maxRadius) active = false;
+        }
+    }
+
+    bool hit(const glm::vec3& pos) {
+        float dist = glm::distance(center, pos);
+        return active && dist <= radius;
+    }
+
+    const glm::mat4& getModel() {
+        xf.setPosition(center);
+        xf.setScale(glm::vec3(radius, 1.0f, radius));
+        return xf.world();
+    }
+};
+
+// Sürekli çarpışma testleri: bir adım boyunca konumlar ve dalga yarıçapı doğrusal değişir kabul edilir.
+// toi: adımın [0, 1] içindeki ilk temas anı. Böylece iri adımlarda (düşük tick, dash) temaslar atlanmaz.
+struct Sweep {
+    static const float catchRadius; // Oyuncu ve kovalayıcı yarıçapları toplamı
+
+    // a0->a1 ve b0->b1 hareket eden, yarıçapları toplamı r olan iki küre
+    static bool spheres(const glm::vec3& a0, const glm::vec3& a1, const glm::vec3& b0, const glm::vec3& b1, float r, float& toi) {
+        glm::vec3 d = a0 - b0, v = (a1 - a0) - (b1 - b0);
+        float c = glm::dot(d, d) - r * r;
+        if (c <= 0.0f) { toi = 0.0f; return true; }
+        float a = glm::dot(v, v), b = glm::dot(d, v);
+        if (b >= 0.0f || a < 1e-12f) return false; // Birbirinden uzaklaşıyor ya da göreli hareket yok
+        float disc = b * b - a * c;
+        if (disc < 0.0f) return false;
+        float t = (-b - sqrt(disc)) / a;
+        if (t > 1.0f) return false;
+        toi = t;
+        return true;
+    }
+
+    // Merkezi sabit, yarıçapı r0->r1 büyüyen dalga diski ile p0->p1 hareket eden nokta.
+    // |d(t)| - r(t) t'de konveks olduğundan ilk temas |d(t)|^2 = r(t)^2 denkleminin küçük kökünde.
+    static bool ring(const glm::vec3& center, float r0, float r1, const glm::vec3& p0, const glm::vec3& p1, float& toi) {
+        glm::vec3 d = p0 - center, v = p1 - p0;
+        float dr = r1 - r0;
+        float c = glm::dot(d, d) - r0 * r0;
+        if (c <= 0.0f && r0 >= 0.0f) { toi = 0.0f; return true; }
+        float a = glm::dot(v, v) - dr * dr, b = glm::dot(d, v) - r0 * dr;
+        float roots[2];
+        int count = 0;
+        if (fabs(a) < 1e-12f) {
+            if (fabs(b) < 1e-12f) return false;
+            roots[count++] = -c / (2.0f * b);
+        }
+        else {
+            float disc = b * b - a * c;
+            if (disc < 0.0f) return false;
+            float sq = sqrt(disc);
+            roots[count++] = (-b - sq) / a;
+            roots[count++] = (-b + sq) / a;
+            if (roots[0] > roots[1]) std::swap(roots[0], roots[1]);
+        }
+        for (int i = 0; i < count; ++i) {
+            float t = roots[i];
+            if (t >= 0.0f && t <= 1.0f && r0 + dr * t >= 0.0f) { toi = t; return true; }
+        }
+        return false;
+    }
+};
+const float Sweep::catchRadius = 1.15f;
+
+// Akış alanının simülasyonu etkileyen durumu (hedef hız tahmini); geri kalanı bundan yeniden hesaplanır
+struct FlowFieldState {
+    glm::vec2 lastTarget, targetVel;
+    bool hasTarget;
+};
+
+// Arena üzerinde ortak akış alanı (flow field): oyuncuya (tahmini konumuna) giden en ucuz yönler
+// Hedef hücre değişince tamamen yeniden hesaplanır (kaynak değişince tüm en kısa yol ağacı değişir); yalnızca
+// maliyet değişince (dalga büyür, biter, engel) değişen hücrelerden onarılır. Her kovalayıcı O(1) örnekler
+class FlowField : public FlowFieldState {
+public:
+    static const int N = 40;                 // N x N hücre
+    float half, cellSize;                    // Arenayı çevreleyen [-half, half] karesi
+    const float leadTime = 0.3f;             // Oyuncu konumunu bu kadar ileriye tahmin et
+    const float wavePenalty = 8.0f, waveMargin = 2.0f;
+    static const unsigned char blocked = 255;
+
+    vector<unsigned char> baseCost;          // Statik engeller (arena dışı, sütunlar...)
+    vector<float> cost, integration;
+    vector<int> parent;                      // En kısa yol ağacında hedefe doğru sonraki hücre, -1: hedef ya da ulaşılamaz
+    vector<glm::vec2> flow;
+    vector<pair<float, int>> heap;
+    vector<int> affected, touched;           // Onarım listeleri (üye: kararlı durumda ayırmasız)
+    vector<unsigned char> mark;
+    glm::vec2 target, waveCenter;
+    glm::ivec2 targetCell;
+    int waveCells;                           // Dalga yarıçapı (hücre cinsinden), -1 = dalga yok
+    bool dirty, costDirty;                   // dirty: tam yeniden hesap; costDirty: maliyetten onarım
+
+    FlowField() : half(ArenaMap::current().boundRadius), cellSize(2.0f * half / N), baseCost(N * N, 1), cost(N * N, 1.0f), integration(N * N, 0.0f),
+        parent(N * N, -1), flow(N * N, glm::vec2(0.0f)), mark(N * N, 0), target(0.0f), waveCenter(0.0f), targetCell(-1, -1), waveCells(-1), dirty(true), costDirty(false) {
+        lastTarget = targetVel = glm::vec2(0.0f);
+        hasTarget = false;
+        // Küp merkezinin giremeyeceği hücreler (duvar, sütunlar) arenanın SDF'inden
+        for (int y = 0; y < N; ++y)
+            for (int x = 0; x < N; ++x)
+                if (ArenaMap::current().distance(cellCenter(x, y)) < ArenaMap::bodyRadius) baseCost[y * N + x] = blocked;
+    }
+
+    const FlowFieldState& state() const { return *this; }
+    void restore(const FlowFieldState& s) {
+        static_cast<FlowFieldState&>(*this) = s;
+        targetCell = glm::ivec2(-1, -1); // Sonraki update alanı yeniden kurar
+    }
+
+    glm::vec2 cellCenter(int x, int y) const { return glm::vec2(-half + (x + 0.5f) * cellSize, -half + (y + 0.5f) * cellSize); }
+    glm::ivec2 cellOf(const glm::vec2& p) const {
+        return glm::ivec2(glm::clamp(static_cast<int>((p.x + half) / cellSize), 0, N - 1), glm::clamp(static_cast<int>((p.y + half) / cellSize), 0, N - 1));
+    }
+
+    // Dinamik engeller için: daire içindeki hücrelere statik maliyet (blocked = geçilemez)
+    void setObstacle(const glm::vec2& center, float radius, unsigned char value = blocked) {
+        for (int y = 0; y < N; ++y)
+            for (int x = 0; x < N; ++x)
+                if (glm::distance(cellCenter(x, y), center) <= radius + cellSize * 0.5f) baseCost[y * N + x] = value;
+        costDirty = true;
+    }
+
+    void update(const glm::vec3& playerPos, float dt, const Wave& wave) {
+        glm::vec2 p(playerPos.x, playerPos.z);
+        if (hasTarget && dt > 0.0f) targetVel = glm::mix(targetVel, (p - lastTarget) / dt, 0.2f);
+        lastTarget = p;
+        hasTarget = true;
+
+        target = p + targetVel * leadTime;
+        target = ArenaMap::current().push(target, ArenaMap::bodyRadius);
+        glm::ivec2 cell = cellOf(target);
+        if (baseCost[cell.y * N + cell.x] == blocked) cell = cellOf(p);
+        if (cell != targetCell) { targetCell = cell; dirty = true; }
+
+        int w = wave.active ? static_cast<int>((wave.radius + waveMargin) / cellSize) : -1;
+        glm::vec2 center(wave.center.x, wave.center.z);
+        if (w != waveCells || (w >= 0 && center != waveCenter)) { waveCells = w; waveCenter = center; costDirty = true; }
+
+        // Dalga hedefi içine alıyorsa her yol halkadan geçer, onarım tüm alanı yeniden kurar: doğrudan tam hesap
+        if (costDirty && waveCells >= 0 && glm::distance(cellCenter(targetCell.x, targetCell.y), waveCenter) <= waveCells * cellSize) dirty = true;
+        if (dirty) rebuild();
+        else if (costDirty) repair();
+    }
+
+    void rebuild() {
+        for (int i = 0; i < N * N; ++i) {
+            cost[i] = cellCost(i);
+            integration[i] = inf();
+            parent[i] = -1;
+            mark[i] = 0;
+        }
+
+        // Dijkstra (8 komşu, köşe kesme yok); heap üye vektör, kararlı durumda bellek ayırmaz
+        int start = targetCell.y * N + targetCell.x;
+        integration[start] = 0.0f;
+        heap.clear();
+        heap.push_back({ 0.0f, start });
+        relax(false);
+
+        // Her hücre en düşük toplam maliyetli komşusuna yönelir
+        for (int i = 0; i < N * N; ++i) updateFlow(i);
+        dirty = costDirty = false;
+    }
+
+    // Maliyeti artan hücrelerin en kısa yol alt ağaçları geçersizlenir, komşularından yeniden tohumlanır; maliyeti
+    // düşenler komşularından yeniden hesaplanır. Dijkstra yalnızca bu tohumlardan yayılır, akış yalnızca değerleri
+    // değişen hücrelerle komşularında yenilenir. Geçilebilirlik değişirse (köşe kesme kuralı) ya da alanın yarısı
+    // geçersizlenirse tam hesaba düşülür.
+    void repair() {
+        const int start = targetCell.y * N + targetCell.x;
+        affected.clear();
+        touched.clear();
+        for (int i = 0; i < N * N; ++i) {
+            float c = cellCost(i);
+            if (c == cost[i]) continue;
+            if ((c >= inf()) != (cost[i] >= inf())) { rebuild(); return; }
+            bool raised = c > cost[i];
+            cost[i] = c;
+            if (i == start) continue;
+            if (raised) { mark[i] = AFFECTED; affected.push_back(i); }
+            else touched.push_back(i);
+        }
+        // Artanların alt ağaçları: çocuklar, parent'ı bu hücre olan komşulardır
+        for (size_t q = 0; q < affected.size(); ++q) {
+            int p = affected[q], px = p % N, py = p / N;
+            integration[p] = inf();
+            parent[p] = -1;
+            for (int d = 0; d < 8; ++d) {
+                int nx = px + dirX(d), ny = py + dirY(d);
+                if (nx < 0 || ny < 0 || nx >= N || ny >= N) continue;
+                int n = ny * N + nx;
+                if (parent[n] == p && !mark[n]) { mark[n] = AFFECTED; affected.push_back(n); }
+            }
+            if (affected.size() > N * N / 2) { rebuild(); return; }
+        }
+        for (int i : touched) {
+            if (mark[i]) continue;
+            mark[i] = AFFECTED;
+            affected.push_back(i);
+        }
+        touched.clear();
+        if (affected.size() > N * N / 2) { rebuild(); return; }
+
+        heap.clear();
+        for (int i : affected) {
+            int cx = i % N, cy = i / N;
+            for (int d = 0; d < 8; ++d) {
+                int nx = cx + dirX(d), ny = cy + dirY(d);
+                if (nx < 0 || ny < 0 || nx >= N || ny >= N || !passable(nx, ny, cx, cy, d)) continue;
+                int n = ny * N + nx;
+                float c = integration[n] + step(d) * cost[i];
+                if (c < integration[i]) { integration[i] = c; parent[i] = n; }
+            }
+            if (integration[i] < inf()) heap.push_back({ integration[i], i });
+            mark[i] = TOUCHED;
+            touched.push_back(i);
+        }
+        std::make_heap(heap.begin(), heap.end(), heapOrder);
+        relax(true);
+
+        for (size_t t = 0, count = touched.size(); t < count; ++t) {
+            int i = touched[t], cx = i % N, cy = i / N;
+            for (int d = 0; d < 8; ++d) {
+                int nx = cx + dirX(d), ny = cy + dirY(d);
+                if (nx < 0 || ny < 0 || nx >= N || ny >= N || mark[ny * N + nx]) continue;
+                mark[ny * N + nx] = TOUCHED;
+                touched.push_back(ny * N + nx);
+            }
+        }
+        for (int i : touched) {
+            updateFlow(i);
+            mark[i] = 0;
+        }
+        costDirty = false;
+    }
+
+private:
+    enum { AFFECTED = 1, TOUCHED = 2 };
+
+    static float inf() { return 1e30f; }
+    static int dirX(int d) { static const int dx[8] = { 1, -1, 0, 0, 1, 1, -1, -1 }; return dx[d]; }
+    static int dirY(int d) { static const int dy[8] = { 0, 0, 1, -1, 1, -1, 1, -1 }; return dy[d]; }
+    static float step(int d) { return d < 4 ? 1.0f : 1.4142f; }
+    static bool heapOrder(const pair<float, int>& a, const pair<float, int>& b) { return a.first > b.first; }
+
+    float cellCost(int i) const {
+        float c = baseCost[i] == blocked ? inf() : baseCost[i];
+        if (c < inf() && waveCells >= 0 && glm::distance(cellCenter(i % N, i / N), waveCenter) <= waveCells * cellSize) c += wavePenalty;
+        return c;
+    }
+
+    // (cx, cy) -> (nx, ny) adımı: hedef geçilebilir ve çaprazda iki yan hücre de açık
+    bool passable(int cx, int cy, int nx, int ny, int d) const {
+        if (cost[ny * N + nx] >= inf()) return false;
+        return d < 4 || (cost[cy * N + nx] < inf() && cost[ny * N + cx] < inf());
+    }
+
+    // Yığındaki tohumlardan Dijkstra; track: değeri değişen hücreler touched'a (akış yenilemesi için)
+    void relax(bool track) {
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), heapOrder);
+            pair<float, int> top = heap.back();
+            heap.pop_back();
+            if (top.first > integration[top.second]) continue;
+            int cx = top.second % N, cy = top.second / N;
+            for (int d = 0; d < 8; ++d) {
+                int nx = cx + dirX(d), ny = cy + dirY(d);
+                if (nx < 0 || ny < 0 || nx >= N || ny >= N || !passable(cx, cy, nx, ny, d)) continue;
+                int n = ny * N + nx;
+                float c = top.first + step(d) * cost[n];
+                if (c < integration[n]) {
+                    integration[n] = c;
+                    parent[n] = top.second;
+                    heap.push_back({ c, n });
+                    std::push_heap(heap.begin(), heap.end(), heapOrder);
+                    if (track && !mark[n]) { mark[n] = TOUCHED; touched.push_back(n); }
+                }
+            }
+        }
+    }
+
+    void updateFlow(int i) {
+        int cx = i % N, cy = i / N;
+        flow[i] = glm::vec2(0.0f);
+        if (integration[i] >= inf() || i == targetCell.y * N + targetCell.x) return;
+        float best = integration[i];
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + dirX(d), ny = cy + dirY(d);
+            if (nx < 0 || ny < 0 || nx >= N || ny >= N) continue;
+            if (d >= 4 && (cost[cy * N + nx] >= inf() || cost[ny * N + cx] >= inf())) continue;
+            int n = ny * N + nx;
+            if (integration[n] < best) { best = integration[n]; flow[i] = glm::normalize(glm::vec2(dirX(d), dirY(d))); }
+        }
+    }
+
+public:
+    // Hücre merkezleri arasında çift doğrusal karışım; geçilemez hücreler katılmaz. Yön yoksa (0,0) döner
+    glm::vec2 sample(const glm::vec3& pos) const {
+        float fx = (pos.x + half) / cellSize - 0.5f, fy = (pos.z + half) / cellSize - 0.5f;
+        int x0 = static_cast<int>(floor(fx)), y0 = static_cast<int>(floor(fy));
+        float tx = fx - x0, ty = fy - y0;
+        glm::vec2 dir(0.0f);
+        for (int j = 0; j < 2; ++j) {
+            for (int i = 0; i < 2; ++i) {
+                int x = x0 + i, y = y0 + j;
+                if (x < 0 || y < 0 || x >= N || y >= N || baseCost[y * N + x] == blocked) continue;
+                dir += flow[y * N + x] * ((i ? tx : 1.0f - tx) * (j ? ty : 1.0f - ty));
+            }
+        }
+        float len = glm::length(dir);
+        return len > 0.001f ? dir / len : glm::vec2(0.0f);
+    }
+};
+
+struct AIState {
+    glm::vec3 pos, vel;
+    float rollAngle, speed, stunTime;
+};
+
+class AI : public AIState {
+public:
+    const float baseSpeed = 2.6f;
+
+    Transform xf;
+
+    AI(glm::vec3 startPos) { pos = startPos; vel = glm::vec3(0.0f); rollAngle = 0.0f; speed = 2.5f; stunTime = 0.0f; }
+
+    AIState& state() { return *this; }
+    const AIState& state() const { return *this; }
+
+    glm::mat4 getRollMatrix(Camera& cam) {
+        return glm::rotate(glm::mat4(1.0f), rollAngle, glm::vec3(0, 0, 1));
+    }
+
+    const glm::mat4& getModel() {
+        xf.setPosition(pos);
+        xf.setRotation(rollAngle, glm::vec3(0, 0, 1));
+        return xf.world();
+    }
+
+    void update(glm::vec3 playerPos, float dt, Wave& wave, const FlowField& field) {
+        TRACE_SCOPE("AI::update");
+        if (stunTime > 0) {
+            stunTime -= dt;
+            if (stunTime < 0) stunTime = 0;
+            return;
+        }
+
+        glm::vec3 dir = playerPos - pos;
+        float dist = glm::length(dir);
+        dir = glm::normalize(dir);
+        // Yakın takipte doğrudan oyuncuya, uzakta ortak akış alanını izle
+        if (dist >= 2.0f) {
+            glm::vec2 flow = field.sample(pos);
+            if (flow != glm::vec2(0.0f)) dir = glm::vec3(flow.x, 0.0f, flow.y);
+        }
+
+        if (wave.active) {
+            float waveDist = glm::length(wave.center - pos) - wave.radius;
+            if (waveDist <= 0) {
+                speed = 0;
+                return;
+            }
+            else if (waveDist < 2.0f) {
+                dir = -dir;
+                speed = baseSpeed * 3.2f;
+            }
+        }
+
+        speed = (dist < 2.0f) ? baseSpeed * 2.0f :
+            (glm::length(playerPos - (pos - vel * dt)) > 5.0f) ? baseSpeed * 2.5f : baseSpeed;
+
+        pos += dir * speed * dt;
+        pos.y = 0.5f;
+        rollAngle += 3.0f * dt;
+    }
+
+    // Duvar ve sütunlardan dışarı it; sunucu tüm kovalayıcıları ArenaMap'in toplu örneklemesiyle iter
+    void confine() { pos = ArenaMap::current().push(pos, ArenaMap::bodyRadius); }
+};
+
+// Tüm değişken simülasyon durumu tek düz blokta: snapshot/restore bir memcpy
+struct WorldState {
+    uint32_t tick;
+    float gameTime;
+    PlayerState player;
+    AIState ai;
+    WaveState wave;
+    FlowFieldState flow;
+    bool caught; // Yakalanma da durumun parçası: temas öncesine geri sarılınca kalkar
+};
+static_assert(std::is_trivially_copyable<WorldState>::value, "WorldState must stay plain data");
+
+// Son N tick'in durumları; geri sarma (rollback) için
+template<typename State, size_t N>
+class StateRing {
+public:
+    State states[N];
+    size_t count, head; // head: sıradaki yazılacak yuva
+
+    StateRing() : count(0), head(0) {}
+
+    void clear() { count = head = 0; }
+    void push(const State& s) {
+        states[head] = s;
+        head = (head + 1) % N;
+        if (count < N) ++count;
+    }
+    // 0 = en son kaydedilen; elde yoksa nullptr
+    const State* back(size_t ticksAgo) const {
+        if (ticksAgo >= count) return nullptr;
+        return &states[(head + N - 1 - ticksAgo) % N];
+    }
+    // Son ticksAgo durumu atar ve o ana ait durumu döner (ör. ölünce birkaç saniye geri sar)
+    const State* rewind(size_t ticksAgo) {
+        const State* s = back(ticksAgo);
+        if (!s) return nullptr;
+        head = (head + N - ticksAgo) % N;
+        count -= ticksAgo;
+        return s;
+    }
+};
+
+// Hızlı, tohumlanabilir PRNG (xorshift64*), aynı tohum aynı dizilimi verir
+class Rng {
+public:
+    uint64_t state;
+
+    Rng(uint64_t seed = 0x9E3779B97F4A7C15ull) : state(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+
+    uint32_t nextU32() {
+        state ^= state >> 12; state ^= state << 25; state ^= state >> 27;
+        return static_cast<uint32_t>((state * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+    float nextFloat() { return (nextU32() >> 8) * (1.0f / 16777216.0f); } // [0, 1)
+    uint32_t nextBelow(uint32_t n) { return static_cast<uint32_t>((static_cast<uint64_t>(nextU32()) * n) >> 32); }
+};
+
+// Bridson tarzı Poisson-disk örnekleme, halka (annulus) üzerinde, arka plan ızgarası ile O(n)
+class PoissonDisk {
+public:
+    // Halkayı minDist aralıklarla doldurur; maxCount'a ulaşınca ya da yer kalmayınca durur, yerleştirilen sayıyı döner
+    static size_t sampleAnnulus(Rng& rng, float inner, float outer, float minDist, size_t maxCount, vector<glm::vec2>& out) {
+        const int k = 6; // Nokta başına deneme (adaylar r*(1+eps) çemberinde eşit açılı)
+        const float pi2 = 2.0f * glm::pi<float>();
+        const float cell = minDist / sqrt(2.0f), invCell = 1.0f / cell, r2 = minDist * minDist;
+        const float inner2 = inner * inner, outer2 = outer * outer;
+        // Her kenarda 2 hücre dolgu: komşu aramasında sınır kontrolü gerekmez
+        const int dim = static_cast<int>(ceil(2.0f * outer * invCell)) + 5;
+        vector<int32_t> grid(static_cast<size_t>(dim) * dim, -1);
+        vector<uint32_t> active;
+        out.clear();
+        if (maxCount == 0) return 0;
+
+        // 5x5 komşuluk (köşeler hariç 21 hücre), en olası çakışma önce kontrol edilsin diye yakından uzağa sıralı
+        int offsets[21], n = 0;
+        for (int d = 0; d <= 5; ++d)
+            for (int y = -2; y <= 2; ++y)
+                for (int x = -2; x <= 2; ++x)
+                    if (x * x + y * y == d) offsets[n++] = y * dim + x;
+        float dirX[k], dirY[k];
+        for (int j = 0; j < k; ++j) { dirX[j] = cos(pi2 * j / k); dirY[j] = sin(pi2 * j / k); }
+
+        auto tryAdd = [&](float x, float y) {
+            float d2 = x * x + y * y;
+            if (d2 < inner2 || d2 > outer2) return false;
+            size_t c = static_cast<size_t>(static_cast<int>((y + outer) * invCell) + 2) * dim + static_cast<int>((x + outer) * invCell) + 2;
+            const int32_t* g = &grid[c];
+            for (int i = 0; i < 21; ++i) {
+                int32_t q = g[offsets[i]];
+                if (q >= 0) {
+                    float dx = out[q].x - x, dy = out[q].y - y;
+                    if (dx * dx + dy * dy < r2) return false;
+                }
+            }
+            grid[c] = static_cast<int32_t>(out.size());
+            active.push_back(static_cast<uint32_t>(out.size()));
+            out.push_back({ x, y });
+            return true;
+        };
+
+        // Halka içinde alanca düzgün rastgele başlangıç noktası
+        for (;;) {
+            float angle = rng.nextFloat() * pi2, r = sqrt(inner2 + rng.nextFloat() * (outer2 - inner2));
+            if (tryAdd(r * cos(angle), r * sin(angle))) break;
+        }
+        while (!active.empty() && out.size() < maxCount) {
+            uint32_t a = rng.nextBelow(static_cast<uint32_t>(active.size()));
+            glm::vec2 p = out[active[a]];
+            float angle = rng.nextFloat() * pi2, c = cos(angle) * minDist * 1.0001f, s = sin(angle) * minDist * 1.0001f;
+            bool found = false;
+            for (int j = 0; j < k && !found; ++j) found = tryAdd(p.x + c * dirX[j] - s * dirY[j], p.y + s * dirX[j] + c * dirY[j]);
+            if (!found) { active[a] = active.back(); active.pop_back(); }
+        }
+        return out.size();
+    }
+};
+
+// ---- Ağ: yerel (loopback) yetkili sunucu, delta sıkıştırılmış anlık görüntüler, tahmin + uzlaştırma ----
+
+class UdpSocket {
+public:
+    socket_t sock;
+
+    UdpSocket() : sock(INVALID_SOCKET) {}
+
+    static void startup() {
+#ifdef _WIN32
+        static bool done = false;
+        if (!done) { WSADATA wsa; WSAStartup(MAKEWORD(2, 2), &wsa); done = true; }
+#endif
+    }
+
+    static sockaddr_in address(const char* host, uint16_t port) {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, host, &addr.sin_addr);
+        return addr;
+    }
+
+    // port 0 = işletim sistemi seçer; bloklamayan soket
+    bool open(const char* host, uint16_t port) {
+        startup();
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock == INVALID_SOCKET) return false;
+        int bufSize = 1 << 20;
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&bufSize, sizeof(bufSize));
+        setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (const char*)&bufSize, sizeof(bufSize));
+        sockaddr_in addr = address(host, port);
+        if (bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0) { close(); return false; }
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ioctlsocket(sock, FIONBIO, &nonBlocking);
+#else
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        return true;
+    }
+
+    int send(const sockaddr_in& to, const uint8_t* data, size_t size) {
+        return static_cast<int>(sendto(sock, (const char*)data, static_cast<int>(size), 0, (const sockaddr*)&to, sizeof(to)));
+    }
+
+    // Bekleyen datagram yoksa -1 döner
+    int receive(sockaddr_in& from, uint8_t* data, size_t capacity) {
+        socklen_t len = sizeof(from);
+        return static_cast<int>(recvfrom(sock, (char*)data, static_cast<int>(capacity), 0, (sockaddr*)&from, &len));
+    }
+
+    void close() {
+        if (sock != INVALID_SOCKET) closesocket(sock);
+        sock = INVALID_SOCKET;
+    }
+
+    ~UdpSocket() { close(); }
+};
+
+class NetWriter {
+public:
+    uint8_t* data;
+    size_t size, capacity;
+    bool overflow;
+
+    NetWriter(uint8_t* buffer, size_t cap) : data(buffer), size(0), capacity(cap), overflow(false) {}
+
+    void u8(uint8_t v) { if (size < capacity) data[size++] = v; else overflow = true; }
+    void u16(uint16_t v) { u8(v & 0xFF); u8(v >> 8); }
+    void u32(uint32_t v) { u16(v & 0xFFFF); u16(v >> 16); }
+    void varint(uint32_t v) { while (v >= 0x80) { u8(static_cast<uint8_t>(v | 0x80)); v >>= 7; } u8(static_cast<uint8_t>(v)); }
+    void svarint(int32_t v) { varint((static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31)); } // zigzag
+};
+
+class NetReader {
+public:
+    const uint8_t* data;
+    size_t size, pos;
+    bool error;
+
+    NetReader(const uint8_t* buffer, size_t n) : data(buffer), size(n), pos(0), error(false) {}
+
+    uint8_t u8() { if (pos < size) return data[pos++]; error = true; return 0; }
+    uint16_t u16() { uint16_t lo = u8(); return static_cast<uint16_t>(lo | (u8() << 8)); }
+    uint32_t u32() { uint32_t lo = u16(); return lo | (static_cast<uint32_t>(u16()) << 16); }
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t b = u8();
+            v |= static_cast<uint32_t>(b & 0x7F) << shift;
+            if (!(b & 0x80) || error) return v;
+        }
+        error = true;
+        return v;
+    }
+    int32_t svarint() { uint32_t v = varint(); return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1); }
+};
+
+// Nicelenmiş (quantized) varlık: her alan int16, delta kodlama alan alan yapılır
+struct NetEntity {
+    enum { MAX_FIELDS = 16 };
+    int16_t f[MAX_FIELDS];
+};
+
+enum PlayerField { PF_POS_X, PF_POS_Y, PF_POS_Z, PF_ROLL_X, PF_ROLL_Z, PF_JUMP_VEL, PF_ROLL_TIME, PF_DASH_TIME, PF_DASH_COOL, PF_SUPER_COOL, PF_FLAGS, PF_WAVE_X, PF_WAVE_Z, PF_WAVE_RADIUS, PF_CAUGHT, PF_COUNT };
+enum ChaserField { CF_POS_X, CF_POS_Y, CF_POS_Z, CF_ROLL, CF_STUN, CF_SPEED, CF_COUNT };
+enum PlayerFlag { PFLAG_PRESENT = 1, PFLAG_ROLLING = 2, PFLAG_JUMPING = 4, PFLAG_DASHING = 8, PFLAG_SUPER_USED = 16, PFLAG_MOVING = 32, PFLAG_WAVE_TRIGGERED = 64, PFLAG_WAVE_ACTIVE = 128, PFLAG_ABILITIES = 256 };
+enum NetMessage { MSG_HELLO = 1, MSG_WELCOME, MSG_INPUT, MSG_SNAPSHOT, MSG_BYE };
+
+// Sunucunun bir tick'teki dünyası, nicelenmiş hâliyle (delta tabanı olarak saklanır)
+struct NetWorld {
+    enum { MAX_PLAYERS = 128, MAX_CHASERS = 128 };
+    uint32_t tick;
+    uint16_t playerCount, chaserCount;
+    NetEntity players[MAX_PLAYERS];
+    NetEntity chasers[MAX_CHASERS];
+};
+
+class NetCodec {
+public:
+    static const uint16_t defaultPort = 27015;
+    static const int maxPacket = 65000;
+    static const int inputRedundancy = 4; // Her pakette son 4 girdi (kayıplara karşı)
+
+    static int16_t q(float v, float scale) { return static_cast<int16_t>(glm::clamp(static_cast<float>(floor(v * scale + 0.5f)), -32767.0f, 32767.0f)); }
+    static float dq(int16_t v, float scale) { return v / scale; }
+
+    static NetEntity quantizePlayer(const Player& p, const Wave& wave, int caught, bool present) {
+        NetEntity e = {};
+        e.f[PF_POS_X] = q(p.pos.x, 1000.0f); e.f[PF_POS_Y] = q(p.pos.y, 1000.0f); e.f[PF_POS_Z] = q(p.pos.z, 1000.0f);
+        e.f[PF_ROLL_X] = q(p.rollDir.x, 10000.0f); e.f[PF_ROLL_Z] = q(p.rollDir.z, 10000.0f);
+        e.f[PF_JUMP_VEL] = q(p.jumpVel, 1000.0f);
+        e.f[PF_ROLL_TIME] = q(p.rollTime, 1000.0f); e.f[PF_DASH_TIME] = q(p.dashTime, 1000.0f);
+        e.f[PF_DASH_COOL] = q(p.dashCool, 1000.0f); e.f[PF_SUPER_COOL] = q(p.superJumpCool, 1000.0f);
+        e.f[PF_FLAGS] = static_cast<int16_t>((present ? PFLAG_PRESENT : 0) | (p.rolling ? PFLAG_ROLLING : 0) | (p.jumping ? PFLAG_JUMPING : 0) |
+            (p.dashing ? PFLAG_DASHING : 0) | (p.superJumpUsed ? PFLAG_SUPER_USED : 0) | (p.isMoving ? PFLAG_MOVING : 0) |
+            (p.waveTriggered ? PFLAG_WAVE_TRIGGERED : 0) | (wave.active ? PFLAG_WAVE_ACTIVE : 0) | (p.enableAbilities ? PFLAG_ABILITIES : 0));
+        e.f[PF_WAVE_X] = q(wave.center.x, 1000.0f); e.f[PF_WAVE_Z] = q(wave.center.z, 1000.0f); e.f[PF_WAVE_RADIUS] = q(wave.radius, 1000.0f);
+        e.f[PF_CAUGHT] = static_cast<int16_t>(caught);
+        return e;
+    }
+
+    static void applyPlayer(const NetEntity& e, Player& p, Wave& wave) {
+        p.pos = glm::vec3(dq(e.f[PF_POS_X], 1000.0f), dq(e.f[PF_POS_Y], 1000.0f), dq(e.f[PF_POS_Z], 1000.0f));
+        p.rollDir = glm::vec3(dq(e.f[PF_ROLL_X], 10000.0f), 0.0f, dq(e.f[PF_ROLL_Z], 10000.0f));
+        if (glm::length(p.rollDir) > 0.9f) p.lastValidRollDir = p.rollDir;
+        p.jumpVel = dq(e.f[PF_JUMP_VEL], 1000.0f);
+        p.rollTime = dq(e.f[PF_ROLL_TIME], 1000.0f); p.dashTime = dq(e.f[PF_DASH_TIME], 1000.0f);
+        p.dashCool = dq(e.f[PF_DASH_COOL], 1000.0f); p.superJumpCool = dq(e.f[PF_SUPER_COOL], 1000.0f);
+        int flags = static_cast<uint16_t>(e.f[PF_FLAGS]);
+        p.rolling = (flags & PFLAG_ROLLING) != 0; p.jumping = (flags & PFLAG_JUMPING) != 0; p.dashing = (flags & PFLAG_DASHING) != 0;
+        p.superJumpUsed = (flags & PFLAG_SUPER_USED) != 0; p.isMoving = (flags & PFLAG_MOVING) != 0;
+        p.waveTriggered = (flags & PFLAG_WAVE_TRIGGERED) != 0; p.enableAbilities = (flags & PFLAG_ABILITIES) != 0;
+        wave.active = (flags & PFLAG_WAVE_ACTIVE) != 0;
+        wave.center = glm::vec3(dq(e.f[PF_WAVE_X], 1000.0f), 0.0f, dq(e.f[PF_WAVE_Z], 1000.0f));
+        wave.radius = dq(e.f[PF_WAVE_RADIUS], 1000.0f);
+    }
+
+    // Her girdi adımından sonra hem sunucu hem istemci nicelenmiş duruma oturur; aynı girdiler birebir aynı sonucu verir
+    static void snap(Player& p, Wave& wave) {
+        applyPlayer(quantizePlayer(p, wave, 0, true), p, wave);
+    }
+
+    static NetEntity quantizeChaser(const AI& ai) {
+        NetEntity e = {};
+        e.f[CF_POS_X] = q(ai.pos.x, 1000.0f); e.f[CF_POS_Y] = q(ai.pos.y, 1000.0f); e.f[CF_POS_Z] = q(ai.pos.z, 1000.0f);
+        e.f[CF_ROLL] = q(static_cast<float>(fmod(ai.rollAngle, 2.0f * glm::pi<float>())), 5000.0f);
+        e.f[CF_STUN] = q(ai.stunTime, 1000.0f); e.f[CF_SPEED] = q(ai.speed, 1000.0f);
+        return e;
+    }
+
+    static void applyChaser(const NetEntity& e, AI& ai) {
+        ai.pos = glm::vec3(dq(e.f[CF_POS_X], 1000.0f), dq(e.f[CF_POS_Y], 1000.0f), dq(e.f[CF_POS_Z], 1000.0f));
+        ai.rollAngle = dq(e.f[CF_ROLL], 5000.0f); ai.stunTime = dq(e.f[CF_STUN], 1000.0f); ai.speed = dq(e.f[CF_SPEED], 1000.0f);
+    }
+
+    // Girdi: bakış yönü yaw/pitch olarak (0.01 derece), tuşlar bit olarak; istemci de aynı nicelenmiş girdiyle tahmin yapar
+    static void writeInput(NetWriter& w, uint32_t seq, const PlayerInput& in) {
+        w.u32(seq);
+        w.u16(static_cast<uint16_t>(q(glm::degrees(atan2(in.front.z, in.front.x)), 100.0f)));
+        w.u16(static_cast<uint16_t>(q(glm::degrees(asin(glm::clamp(in.front.y, -1.0f, 1.0f))), 100.0f)));
+        w.u8(static_cast<uint8_t>((in.forward ? 1 : 0) | (in.back ? 2 : 0) | (in.left ? 4 : 0) | (in.right ? 8 : 0) |
+            (in.jump ? 16 : 0) | (in.superJump ? 32 : 0) | (in.dash ? 64 : 0)));
+    }
+
+    static PlayerInput readInput(NetReader& r, uint32_t& seq, float tickDt) {
+        PlayerInput in;
+        seq = r.u32();
+        float yaw = glm::radians(dq(static_cast<int16_t>(r.u16()), 100.0f)), pitch = glm::radians(dq(static_cast<int16_t>(r.u16()), 100.0f));
+        in.front = glm::vec3(cos(yaw) * cos(pitch), sin(pitch), sin(yaw) * cos(pitch));
+        in.time = seq * tickDt;
+        uint8_t b = r.u8();
+        in.forward = (b & 1) != 0; in.back = (b & 2) != 0; in.left = (b & 4) != 0; in.right = (b & 8) != 0;
+        in.jump = (b & 16) != 0; in.superJump = (b & 32) != 0; in.dash = (b & 64) != 0;
+        return in;
+    }
+
+    static PlayerInput quantized(const PlayerInput& in, uint32_t seq, float tickDt) {
+        uint8_t buf[16];
+        NetWriter w(buf, sizeof(buf));
+        writeInput(w, seq, in);
+        NetReader r(buf, w.size);
+        uint32_t s;
+        return readInput(r, s, tickDt);
+    }
+
+    // Değişen alanların maskesi + tabana göre zigzag varint farkları
+    static void writeEntity(NetWriter& w, const NetEntity& e, const NetEntity* base, int fields) {
+        uint32_t mask = 0;
+        for (int i = 0; i < fields; ++i) if (e.f[i] != (base ? base->f[i] : 0)) mask |= 1u << i;
+        w.varint(mask);
+        for (int i = 0; i < fields; ++i) if (mask & (1u << i)) w.svarint(e.f[i] - (base ? base->f[i] : 0));
+    }
+
+    static void readEntity(NetReader& r, NetEntity& e, const NetEntity* base, int fields) {
+        uint32_t mask = r.varint();
+        for (int i = 0; i < fields; ++i) {
+            int32_t b = base ? base->f[i] : 0;
+            e.f[i] = static_cast<int16_t>((mask & (1u << i)) ? b + r.svarint() : b);
+        }
+        for (int i = fields; i < NetEntity::MAX_FIELDS; ++i) e.f[i] = 0;
+    }
+
+    static void writeSnapshot(NetWriter& w, const NetWorld& world, const NetWorld* base, uint32_t ackInput, uint16_t slot) {
+        w.u8(MSG_SNAPSHOT);
+        w.u32(world.tick);
+        w.u32(base ? base->tick : 0);
+        w.u32(ackInput);
+        w.u16(slot);
+        w.u16(world.playerCount);
+        w.u16(world.chaserCount);
+        for (int i = 0; i < world.playerCount; ++i) writeEntity(w, world.players[i], base && i < base->playerCount ? &base->players[i] : nullptr, PF_COUNT);
+        for (int i = 0; i < world.chaserCount; ++i) writeEntity(w, world.chasers[i], base && i < base->chaserCount ? &base->chasers[i] : nullptr, CF_COUNT);
+    }
+
+    // Mesaj tipi okunmuş olmalı; taban bulunamazsa (base == nullptr ama baseTick != 0) çağrılmamalı
+    static bool readSnapshot(NetReader& r, NetWorld& world, const NetWorld* base) {
+        uint16_t players = r.u16(), chasers = r.u16();
+        if (r.error || players > NetWorld::MAX_PLAYERS || chasers > NetWorld::MAX_CHASERS) return false; // Bozuk paket: kırpıp yarısını okumak yerine reddet
+        world.playerCount = players;
+        world.chaserCount = chasers;
+        for (int i = 0; i < world.playerCount; ++i) readEntity(r, world.players[i], base && i < base->playerCount ? &base->players[i] : nullptr, PF_COUNT);
+        for (int i = 0; i < world.chaserCount; ++i) readEntity(r, world.chasers[i], base && i < base->chaserCount ? &base->chasers[i] : nullptr, CF_COUNT);
+        return !r.error;
+    }
+};
+
+// Sunucu kovalayıcılarının zaman dilimli güncellemesi. Her tick her kovalayıcıya bir kip verilir:
+// - yakın takip, dalgadan kaçış ve sersemliği yeni biten: her tick tam güncelleme (bütçeden bağımsız, tam);
+// - sersem: AI::update'in sersem dalı zaten yalnızca sayacı düşürür, her tick doğrudan çağrılır;
+// - uzak: hedefe uzaklığa göre 2/4/8 tick'te bir tam güncelleme, aradaki tick'lerde son hızıyla ilerletilir.
+// Vadesi gelen uzaklar tick başına AI bütçesine (ölçülen güncelleme maliyetiyle) sığdığı kadar, round-robin sırayla
+// güncellenir; sığmayanlar ilerletilip sonraki tick'e kalır. Konumlar her tick ilerlediğinden temas testleri değişmez.
+class AIScheduler {
+public:
+    const float closeRange = 6.0f, waveRange = 4.0f; // Oyuncuya / dalga cephesine bu uzaklığın içi her tick
+    float budgetMs, costMs;                          // Tick başına AI süresi; tam güncelleme başına ölçülen süre
+    size_t updates, required, deferred, coasted;     // Son rapordan beri toplamlar (sunucu günlüğü)
+
+    AIScheduler() : budgetMs(1.0f), costMs(0.01f), updates(0), required(0), deferred(0), coasted(0), cursor(0) {}
+
+    // Uzak kovalayıcının tam güncellemeleri arasındaki tick sayısı
+    static uint32_t interval(float dist) { return dist < 12.0f ? 2u : dist < 24.0f ? 4u : 8u; }
+
+    void step(vector<AI>& chasers, const vector<int>& targets, const vector<Player>& players, vector<Wave>& waves, const vector<FlowField>& fields,
+        float tickDt, uint32_t tick) {
+        if (agents.size() != chasers.size()) {
+            agents.assign(chasers.size(), Agent());
+            selected.reserve(chasers.size());
+        }
+        selected.clear();
+        size_t n = chasers.size(), mandatory = 0;
+        for (size_t a = 0; a < n; ++a) {
+            Agent& g = agents[a];
+            AI& ai = chasers[a];
+            int t = targets[a];
+            g.mode = Agent::IDLE;
+            if (t < 0) continue;
+            if (ai.stunTime > 0.0f) {
+                ai.update(players[t].pos, tickDt, waves[t], fields[t]);
+                g.velocity = glm::vec3(0.0f);
+                g.wake = true;
+                continue;
+            }
+            const Wave& w = waves[t];
+            float dist = glm::length(players[t].pos - ai.pos);
+            if (g.wake || dist < closeRange || (w.active && glm::length(w.center - ai.pos) - w.radius < waveRange)) {
+                g.mode = Agent::UPDATE;
+                selected.push_back(static_cast<uint32_t>(a));
+                mandatory++;
+            }
+            else g.mode = tick - g.lastUpdate >= interval(dist) ? Agent::DUE : Agent::COAST;
+        }
+
+        // Bütçenin kalanı vadesi gelenlere; en az biri her tick ilerler, kimse sonsuza dek ertelenmez
+        size_t capacity = static_cast<size_t>(glm::max(budgetMs / glm::max(costMs, 1e-4f) - static_cast<float>(mandatory), 1.0f));
+        size_t picked = 0;
+        for (size_t i = 0; i < n; ++i) {
+            size_t a = (cursor + i) % n;
+            if (agents[a].mode != Agent::DUE) continue;
+            if (picked == capacity) { deferred++; continue; }
+            agents[a].mode = Agent::UPDATE;
+            selected.push_back(static_cast<uint32_t>(a));
+            cursor = (a + 1) % n;
+            picked++;
+        }
+
+        for (size_t a = 0; a < n; ++a) {
+            Agent::Mode m = agents[a].mode;
+            if (m != Agent::COAST && m != Agent::DUE) continue;
+            AI& ai = chasers[a];
+            ai.pos += agents[a].velocity * tickDt;
+            ai.pos.y = 0.5f;
+            ai.rollAngle += 3.0f * tickDt;
+            coasted++;
+        }
+
+        auto body = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                uint32_t a = selected[i];
+                AI& ai = chasers[a];
+                int t = targets[a];
+                glm::vec3 p0 = ai.pos;
+                ai.update(players[t].pos, tickDt, waves[t], fields[t]);
+                Agent& g = agents[a];
+                g.velocity = (ai.pos - p0) / tickDt;
+                g.velocity.y = 0.0f;
+                g.lastUpdate = tick;
+                g.wake = false;
+            }
+            };
+        auto start = std::chrono::steady_clock::now();
+        JobSystem::current().parallelFor(selected.size(), 16, body);
+        if (!selected.empty()) {
+            float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            costMs = costMs * 0.9f + ms / selected.size() * 0.1f;
+        }
+        updates += selected.size();
+        required += mandatory;
+    }
+
+private:
+    struct Agent {
+        enum Mode { IDLE, UPDATE, DUE, COAST };
+        glm::vec3 velocity = glm::vec3(0.0f); // Son tam güncellemedeki hız, ara tick'lerde ilerletme için
+        uint32_t lastUpdate = 0;
+        Mode mode = IDLE;
+        bool wake = false;                    // Sersemlik bitti: hızı eskidi, ilk tick tam güncellenir
+    };
+    vector<Agent> agents;
+    vector<uint32_t> selected;
+    size_t cursor;
+};
+
+// Yetkili sunucu: Player/AI/Wave simülasyonunu sabit tick'te koşturur, UDP girdileri alır, delta görüntüler yollar
+class GameServer {
+public:
+    struct Client {
+        sockaddr_in addr;
+        bool active;
+        uint32_t lastInput, ackTick;  // Son işlenen girdi, istemcinin son aldığı görüntü
+        PlayerInput inputs[64];       // seq % 64 ile indekslenen girdi kuyruğu
+        uint32_t newestInput;
+        PlayerInput current;          // Son işlenen girdi
+        double lastHeard;
+        int caught;
+    };
+    enum { HISTORY = 64 };
+
+    UdpSocket sock;
+    float tickRate, tickDt;
+    uint32_t tick;
+    vector<Client> clients;
+    vector<Player> players;
+    vector<Wave> waves;
+    vector<FlowField> fields;
+    vector<AI> chasers;
+    AIScheduler scheduler;
+    vector<unsigned char> targeted;
+    vector<int> targets;                        // Kovalayıcı başına hedef oyuncu, -1: yok (tick başına ayırmasız)
+    vector<glm::vec3> playerStart, chaserStart; // Tick başı konumlar (süpürülmüş temas testleri için)
+    vector<float> waveStart;                     // Tick başı dalga yarıçapları, dalga yoksa -1
+    vector<float> chaserX, chaserZ, sdf, sdfX, sdfZ; // Kovalayıcıların toplu arena itmesi (SoA)
+    vector<NetWorld> history;
+    vector<uint8_t> packet;
+    Rng rng;
+    double statTick, statTickMax;
+    uint64_t statBytesOut, statBytesIn;
+    int statTicks;
+
+    GameServer(float rate, int chaserCount) : tickRate(rate), tickDt(1.0f / rate), tick(0), clients(NetWorld::MAX_PLAYERS),
+        players(NetWorld::MAX_PLAYERS, Player(glm::vec3(ArenaMap::current().playerSpawn.x, 0.5f, ArenaMap::current().playerSpawn.y), true)), waves(NetWorld::MAX_PLAYERS), fields(NetWorld::MAX_PLAYERS),
+        targeted(NetWorld::MAX_PLAYERS, 0), playerStart(NetWorld::MAX_PLAYERS), chaserStart(NetWorld::MAX_CHASERS), waveStart(NetWorld::MAX_PLAYERS),
+        chaserX(NetWorld::MAX_CHASERS), chaserZ(NetWorld::MAX_CHASERS), sdf(NetWorld::MAX_CHASERS), sdfX(NetWorld::MAX_CHASERS), sdfZ(NetWorld::MAX_CHASERS), history(HISTORY), packet(NetCodec::maxPacket), rng(0x5EEDu),
+        statTick(0.0), statTickMax(0.0), statBytesOut(0), statBytesIn(0), statTicks(0) {
+        for (auto& c : clients) c.active = false;
+        for (int i = 0; i < glm::min(chaserCount, static_cast<int>(NetWorld::MAX_CHASERS)); ++i) {
+            float angle = 2.0f * glm::pi<float>() * i / glm::max(chaserCount, 1);
+            float r = ArenaMap::current().boundRadius * 0.8f;
+            chasers.push_back(AI(glm::vec3(r * cos(angle), 0.5f, r * sin(angle))));
+            chasers.back().confine();
+        }
+        targets.assign(chasers.size(), -1);
+    }
+
+    static double now() { return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+    // Birkaç rastgele aday içinden kovalayıcılara en uzak olanı; duvar ve sütunlara yakın adaylar atlanır
+    glm::vec3 spawnPoint() {
+        const ArenaMap& map = ArenaMap::current();
+        glm::vec3 best(map.playerSpawn.x, 0.5f, map.playerSpawn.y);
+        float bestDist = -1.0f;
+        for (int i = 0; i < 8; ++i) {
+            float angle = rng.nextFloat() * 2.0f * glm::pi<float>(), r = sqrt(rng.nextFloat()) * map.boundRadius;
+            glm::vec3 p(r * cos(angle), 0.5f, r * sin(angle));
+            if (map.distance(glm::vec2(p.x, p.z)) < 2.0f * ArenaMap::bodyRadius) continue;
+            float nearest = 1e30f;
+            for (const AI& a : chasers) nearest = glm::min(nearest, glm::length(a.pos - p));
+            if (nearest > bestDist) { bestDist = nearest; best = p; }
+        }
+        return best;
+    }
+
+    int findClient(const sockaddr_in& addr) {
+        for (int i = 0; i < NetWorld::MAX_PLAYERS; ++i)
+            if (clients[i].active && clients[i].addr.sin_port == addr.sin_port && clients[i].addr.sin_addr.s_addr == addr.sin_addr.s_addr) return i;
+        return -1;
+    }
+
+    void receive(double t) {
+        sockaddr_in from;
+        int n;
+        while ((n = sock.receive(from, packet.data(), packet.size())) > 0) {
+            statBytesIn += n;
+            NetReader r(packet.data(), n);
+            uint8_t type = r.u8();
+            int id = findClient(from);
+            if (type == MSG_HELLO) {
+                if (id < 0) {
+                    for (int i = 0; i < NetWorld::MAX_PLAYERS && id < 0; ++i) if (!clients[i].active) id = i;
+                    if (id < 0) continue; // Sunucu dolu
+                    Client& c = clients[id];
+                    c.active = true; c.addr = from; c.lastInput = c.newestInput = c.ackTick = 0; c.caught = 0;
+                    c.current = PlayerInput();
+                    players[id].reset(spawnPoint());
+                    waves[id].active = false;
+                    std::cout << "Client " << id << " connected" << std::endl;
+                }
+                clients[id].lastHeard = t;
+                uint8_t reply[8];
+                NetWriter w(reply, sizeof(reply));
+                w.u8(MSG_WELCOME); w.u16(static_cast<uint16_t>(id)); w.u16(static_cast<uint16_t>(tickRate));
+                sock.send(from, reply, w.size);
+            }
+            else if (type == MSG_INPUT && id >= 0) {
+                Client& c = clients[id];
+                c.lastHeard = t;
+                uint32_t ack = r.u32();
+                if (ack > c.ackTick && ack <= tick) c.ackTick = ack;
+                int count = r.u8();
+                for (int i = 0; i < count && !r.error; ++i) {
+                    uint32_t seq;
+                    PlayerInput in = NetCodec::readInput(r, seq, tickDt);
+                    if (r.error || seq <= c.lastInput || seq + 64 <= c.newestInput) continue;
+                    c.inputs[seq % 64] = in;
+                    c.newestInput = glm::max(c.newestInput, seq);
+                }
+            }
+            else if (type == MSG_BYE && id >= 0) {
+                clients[id].active = false;
+                std::cout << "Client " << id << " left" << std::endl;
+            }
+        }
+    }
+
+    void simulate(double t) {
+        // İstemci başına yalnızca gelen girdiler işlenir (tahminle aynı adımlar); birikmişse tick başına en fazla 3
+        for (int i = 0; i < NetWorld::MAX_PLAYERS; ++i) {
+            Client& c = clients[i];
+            if (!c.active) continue;
+            playerStart[i] = players[i].pos;
+            if (t - c.lastHeard > 5.0) { c.active = false; std::cout << "Client " << i << " timed out" << std::endl; continue; }
+            if (c.newestInput - c.lastInput > 32) c.lastInput = c.newestInput - 32; // Kuyruk taştı, en eski saklanan girdiye atla
+            for (int step = 0; step < 3 && c.newestInput > c.lastInput; ++step) {
+                c.current = c.inputs[++c.lastInput % 64];
+                players[i].update(c.current, tickDt);
+                NetCodec::snap(players[i], waves[i]);
+                if (players[i].getWaveTriggered()) {
+                    waves[i].center = players[i].pos;
+                    waves[i].radius = 0.0f;
+                    waves[i].active = true;
+                    players[i].resetWave();
+                }
+            }
+        }
+
+        // Kovalayıcılar en yakın oyuncuyu hedefler; yalnız hedeflenen oyuncuların akış alanı güncellenir
+        std::fill(targets.begin(), targets.end(), -1);
+        std::fill(targeted.begin(), targeted.end(), 0);
+        for (size_t a = 0; a < chasers.size(); ++a) {
+            float best = 1e30f;
+            for (int i = 0; i < NetWorld::MAX_PLAYERS; ++i) {
+                if (!clients[i].active) continue;
+                float d = glm::length(players[i].pos - chasers[a].pos);
+                if (d < best) { best = d; targets[a] = i; }
             }
+            if (targets[a] >= 0) targeted[targets[a]] = 1;
         }
-
-        if (enableAbilities && glfwGetKey(win.window, GLFW_KEY_E) == GLFW_PRESS && !dashing && !rolling && dashCool <= 0.0f) {
-            dashing = true;
-            dashTime = 0.0f;
+        // Akış alanları birbirinden bağımsız: iş sisteminde, her biri yalnızca kendi yuvasına yazar; kovalayıcılar zamanlayıcıda
+        auto updateFields = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) if (targeted[i]) fields[i].update(players[i].pos, tickDt, waves[i]);
+            };
+        JobSystem::current().parallelFor(NetWorld::MAX_PLAYERS, 1, updateFields);
+        for (size_t a = 0; a < chasers.size(); ++a) chaserStart[a] = chasers[a].pos;
+        scheduler.step(chasers, targets, players, waves, fields, tickDt, tick);
+        for (size_t a = 0; a < chasers.size(); ++a) {
+            chaserX[a] = chasers[a].pos.x;
+            chaserZ[a] = chasers[a].pos.z;
+        }
+        ArenaMap::current().push(chaserX.data(), chaserZ.data(), sdf.data(), sdfX.data(), sdfZ.data(), chasers.size(), ArenaMap::bodyRadius);
+        for (size_t a = 0; a < chasers.size(); ++a) { chasers[a].pos.x = chaserX[a]; chasers[a].pos.z = chaserZ[a]; }
+        for (int i = 0; i < NetWorld::MAX_PLAYERS; ++i) {
+            waveStart[i] = waves[i].active ? waves[i].radius : -1.0f;
+            if (clients[i].active) waves[i].update(tickDt);
         }
 
-        if (enableAbilities && dashCool > 0.0f) dashCool -= dt;
-        if (dashCool < 0.0f) dashCool = 0.0f;
+        // Temaslar tick boyunca süpürülerek bulunur; düşük tick hızında da dash ile içinden geçilemez
+        for (int i = 0; i < NetWorld::MAX_PLAYERS; ++i) {
+            if (!clients[i].active) continue;
+            float firstCatch = 2.0f, toi;
+            for (size_t a = 0; a < chasers.size(); ++a) {
+                if (waveStart[i] >= 0.0f && Sweep::ring(waves[i].center, waveStart[i], std::min(waves[i].radius, waves[i].maxRadius), chaserStart[a], chasers[a].pos, toi))
+                    chasers[a].stunTime = 2.0f;
+                if (Sweep::spheres(playerStart[i], players[i].pos, chaserStart[a], chasers[a].pos, Sweep::catchRadius, toi))
+                    firstCatch = std::min(firstCatch, toi);
+            }
+            if (firstCatch <= 1.0f) {
+                clients[i].caught++;
+                players[i].reset(spawnPoint());
+                waves[i].active = false;
+            }
+        }
+    }
 
-        if (enableAbilities && superJumpCool > 0.0f) superJumpCool -= dt;
-        if (superJumpCool < 0.0f) superJumpCool = 0.0f;
+    void broadcast() {
+        NetWorld& world = history[tick % HISTORY];
+        world.tick = tick;
+        world.playerCount = 0;
+        for (int i = 0; i < NetWorld::MAX_PLAYERS; ++i) {
+            if (!clients[i].active) { world.players[i] = NetEntity(); continue; }
+            world.players[i] = NetCodec::quantizePlayer(players[i], waves[i], clients[i].caught, true);
+            world.playerCount = static_cast<uint16_t>(i + 1);
+        }
+        world.chaserCount = static_cast<uint16_t>(chasers.size());
+        for (size_t a = 0; a < chasers.size(); ++a) world.chasers[a] = NetCodec::quantizeChaser(chasers[a]);
+
+        for (int i = 0; i < NetWorld::MAX_PLAYERS; ++i) {
+            Client& c = clients[i];
+            if (!c.active) continue;
+            // İstemcinin onayladığı görüntü hâlâ geçmişteyse ona göre delta, yoksa tam görüntü
+            const NetWorld* base = nullptr;
+            if (c.ackTick > 0 && tick - c.ackTick < HISTORY && history[c.ackTick % HISTORY].tick == c.ackTick) base = &history[c.ackTick % HISTORY];
+            NetWriter w(packet.data(), packet.size());
+            NetCodec::writeSnapshot(w, world, base, c.lastInput, static_cast<uint16_t>(i));
+            if (w.overflow) continue;
+            sock.send(c.addr, packet.data(), w.size);
+            statBytesOut += w.size;
+        }
     }
 
-    glm::mat4 getRollMatrix(const Camera& cam, const Window& win) {
-        if (rolling) {
-            float progress = rollTime / rollDur;
-            float angle = glm::radians(360.0f * progress);
-            glm::vec3 axis = glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), lastValidRollDir);
-            if (glm::length(axis) < 0.1f) {
-                axis = glm::vec3(1.0f, 0.0f, 0.0f);
+    int run(uint16_t port) {
+        if (!sock.open("127.0.0.1", port)) { std::cerr << "Failed to bind UDP port " << port << std::endl; return 1; }
+        std::cout << "Server listening on 127.0.0.1:" << port << " at " << tickRate << " Hz with " << chasers.size() << " chasers" << std::endl;
+        double next = now(), lastReport = next;
+        for (;;) {
+            double start = now();
+            ++tick;
+            receive(start);
+            simulate(start);
+            broadcast();
+            double elapsed = now() - start;
+            statTick += elapsed; statTickMax = glm::max(statTickMax, elapsed); statTicks++;
+
+            if (start - lastReport >= 1.0) {
+                int active = 0;
+                for (auto& c : clients) active += c.active ? 1 : 0;
+                double avg = statTick / statTicks, seconds = start - lastReport;
+                std::cout << "tick " << tick << " | clients " << active << " | tick avg " << avg * 1000.0 << " ms max " << statTickMax * 1000.0
+                    << " ms | out " << (active ? statBytesOut / seconds / active / 1024.0 : 0.0) << " KB/s/client | in " << statBytesIn / seconds / 1024.0 << " KB/s";
+                if (active > 0 && avg > 0.0) std::cout << " | ~" << static_cast<int>(active * tickDt / avg) << " clients/core";
+                AIScheduler& ai = scheduler;
+                std::cout << " | AI/tick " << static_cast<double>(ai.updates) / statTicks << " updates (" << static_cast<double>(ai.required) / statTicks << " full-rate), "
+                    << static_cast<double>(ai.coasted) / statTicks << " extrapolated, " << static_cast<double>(ai.deferred) / statTicks << " over budget, "
+                    << ai.costMs * 1000.0f << " us each" << std::endl;
+                ai.updates = ai.required = ai.coasted = ai.deferred = 0;
+                statTick = statTickMax = 0.0; statTicks = 0; statBytesOut = statBytesIn = 0;
+                lastReport = start;
             }
-            axis = glm::normalize(axis);
-            glm::quat rot = glm::angleAxis(angle, axis);
-            return glm::mat4_cast(rot);
+            next += tickDt;
+            double wait = next - now();
+            if (wait > 0.0) std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+            else if (wait < -0.25) next = now(); // Çok geride kaldıysak yakalamaya çalışma
         }
-        return glm::mat4(1.0f);
+        return 0;
     }
-
-    float getDashCool() const { return dashCool; }
-    float getSuperJumpCool() const { return superJumpCool; }
-    bool getWaveTriggered() const { return waveTriggered; }
-    void resetWave() { waveTriggered = false; }
 };
 
-class Wave {
+// İstemci: girdileri sabit tick'te yollar, kendi oyuncusunu tahmin eder, sunucu görüntüsü gelince geri sarıp yeniden oynatır
+class NetClient {
 public:
-    glm::vec3 center;
-    float radius;
-    const float maxRadius = 5.0f;
-    const float growSpeed = 5.0f;
-    bool active;
+    enum { INPUT_HISTORY = 128, WORLD_HISTORY = 16 };
+
+    UdpSocket sock;
+    sockaddr_in server;
+    Player& player;                   // Tahmin edilen yerel oyuncu
+    Wave wave;
+    bool connected;
+    int slot, caught;
+    float tickDt, accumulator;
+    double lastHello, lastSnapshot;
+    uint32_t inputSeq, ackInput, latestTick;
+    PlayerInput inputs[INPUT_HISTORY];
+    bool tapJump, tapSuperJump, tapDash; // Tick düşmeyen karelerdeki basışlar sonraki tick'e taşınır
+    vector<NetWorld> worlds;          // Alınan görüntüler, delta tabanı olarak
+    NetWorld* latest;
+    vector<uint8_t> packet;
+    uint64_t bytesIn, snapshots, dropped, corrections, teleports;
+    double correction;                // Uzlaştırmada oluşan toplam konum düzeltmesi (ışınlanmalar hariç)
+
+    NetClient(Player& p) : player(p), connected(false), slot(-1), caught(0), tickDt(1.0f / 60.0f), accumulator(0.0f), lastHello(-1.0), lastSnapshot(0.0),
+        inputSeq(0), ackInput(0), latestTick(0), tapJump(false), tapSuperJump(false), tapDash(false), worlds(WORLD_HISTORY), latest(nullptr), packet(NetCodec::maxPacket), bytesIn(0), snapshots(0), dropped(0), corrections(0), teleports(0), correction(0.0) {
+        server = {};
+        for (auto& w : worlds) { w.tick = 0; w.playerCount = w.chaserCount = 0; }
+    }
 
-    Wave() : radius(0.0f), active(false) {}
+    bool connect(const char* host, uint16_t port) {
+        server = UdpSocket::address(host, port);
+        return sock.open("0.0.0.0", 0);
+    }
 
-    void update(float dt) {
-        if (active) {
-            radius += growSpeed * dt;
-            if (radius >= maxRadius) active = false;
+    void update(const PlayerInput& in, float dt) {
+        double t = GameServer::now();
+        receive(t);
+        if (connected && t - lastSnapshot > 2.0) connected = false; // Sunucu sustu, yeniden el sıkış
+        if (!connected) {
+            if (t - lastHello > 0.5) {
+                uint8_t hello = MSG_HELLO;
+                sock.send(server, &hello, 1);
+                lastHello = t;
+            }
+            return;
+        }
+
+        tapJump |= in.jump; tapSuperJump |= in.superJump; tapDash |= in.dash;
+        accumulator += dt;
+        while (accumulator >= tickDt) {
+            accumulator -= tickDt;
+            PlayerInput latched = in;
+            latched.jump |= tapJump; latched.superJump |= tapSuperJump; latched.dash |= tapDash;
+            tapJump = tapSuperJump = tapDash = false;
+            PlayerInput cmd = NetCodec::quantized(latched, ++inputSeq, tickDt);
+            inputs[inputSeq % INPUT_HISTORY] = cmd;
+            player.update(cmd, tickDt);
+            NetCodec::snap(player, wave);
+
+            NetWriter w(packet.data(), packet.size());
+            w.u8(MSG_INPUT);
+            w.u32(latestTick);
+            uint32_t count = glm::min<uint32_t>(inputSeq - ackInput, NetCodec::inputRedundancy);
+            w.u8(static_cast<uint8_t>(count));
+            for (uint32_t s = inputSeq - count + 1; s <= inputSeq; ++s) NetCodec::writeInput(w, s, inputs[s % INPUT_HISTORY]);
+            sock.send(server, packet.data(), w.size);
         }
     }
 
-    bool hit(const glm::vec3& pos) {
-        float dist = glm::distance(center, pos);
-        return active && dist <= radius;
+    void receive(double t) {
+        sockaddr_in from;
+        int n;
+        while ((n = sock.receive(from, packet.data(), packet.size())) > 0) {
+            bytesIn += n;
+            NetReader r(packet.data(), n);
+            uint8_t type = r.u8();
+            if (type == MSG_WELCOME) {
+                slot = r.u16();
+                tickDt = 1.0f / glm::max<uint16_t>(r.u16(), 1);
+                if (!connected) { connected = true; lastSnapshot = t; }
+            }
+            else if (type == MSG_SNAPSHOT) {
+                uint32_t tick = r.u32(), baseTick = r.u32(), ack = r.u32();
+                slot = r.u16();
+                if (tick <= latestTick) continue; // Eski ya da tekrar eden paket
+                const NetWorld* base = nullptr;
+                if (baseTick != 0) {
+                    base = &worlds[baseTick % WORLD_HISTORY];
+                    if (base->tick != baseTick) { dropped++; continue; } // Taban elimizde yok
+                }
+                NetWorld& world = worlds[tick % WORLD_HISTORY];
+                if (!NetCodec::readSnapshot(r, world, base)) { world.tick = 0; dropped++; continue; }
+                world.tick = tick;
+                latestTick = tick;
+                latest = &world;
+                lastSnapshot = t;
+                snapshots++;
+                reconcile(world, ack);
+            }
+        }
+    }
+
+    // Sunucunun onayladığı duruma dön, onaylanmamış girdileri yeniden uygula
+    void reconcile(const NetWorld& world, uint32_t ack) {
+        if (slot < 0 || slot >= world.playerCount) return;
+        if (ack < ackInput || inputSeq - ack >= INPUT_HISTORY) return;
+        ackInput = ack;
+        glm::vec3 before = player.pos;
+        const NetEntity& e = world.players[slot];
+        caught = e.f[PF_CAUGHT];
+        NetCodec::applyPlayer(e, player, wave);
+        for (uint32_t s = ack + 1; s <= inputSeq; ++s) {
+            player.update(inputs[s % INPUT_HISTORY], tickDt);
+            NetCodec::snap(player, wave);
+        }
+        float error = glm::length(player.pos - before);
+        if (error > 1.0f) teleports++; // Yakalanıp yeniden doğma
+        else { correction += error; corrections++; }
     }
 
-    glm::mat4 getModel() {
-        return glm::translate(glm::mat4(1.0f), center) *
-            glm::scale(glm::mat4(1.0f), glm::vec3(radius, 1.0f, radius));
+    void disconnect() {
+        uint8_t bye = MSG_BYE;
+        if (connected) sock.send(server, &bye, 1);
+        connected = false;
     }
+
+    ~NetClient() { disconnect(); }
 };
 
-class AI {
+// Yük üreteci: tek süreçte N bot istemci; sunucunun tick süresi, istemci başına bant genişliği ve kapasitesi ölçülür
+class LoadGenerator {
 public:
-    glm::vec3 pos, vel;
-    float rollAngle, speed, baseSpeed, stunTime;
+    struct Bot {
+        Player player;
+        NetClient client;
+        Rng rng;
+        PlayerInput input;
+        float turnTimer;
+        Bot(uint64_t seed) : player(glm::vec3(0.0f, 0.5f, 0.0f), true), client(player), rng(seed), turnTimer(0.0f) {}
+    };
 
-    AI(glm::vec3 startPos) : pos(startPos), vel(0), rollAngle(0), speed(2.5f), baseSpeed(2.6f), stunTime(0) {}
+    static int run(int botCount, uint16_t port, float seconds) {
+        vector<std::unique_ptr<Bot>> bots;
+        for (int i = 0; i < botCount; ++i) {
+            bots.emplace_back(new Bot(0xB07ull + i));
+            if (!bots.back()->client.connect("127.0.0.1", port)) { std::cerr << "Failed to open client socket" << std::endl; return 1; }
+        }
+        std::cout << "Load generator: " << botCount << " bots -> 127.0.0.1:" << port << " for " << seconds << " s" << std::endl;
+        const float dt = 1.0f / 60.0f;
+        double start = GameServer::now(), next = start, lastReport = start;
+        uint64_t lastBytes = 0, lastSnapshots = 0;
+        while (GameServer::now() - start < seconds) {
+            for (auto& bot : bots) {
+                // Rastgele yön, ara sıra zıplama ve dash
+                bot->turnTimer -= dt;
+                if (bot->turnTimer <= 0.0f) {
+                    float yaw = bot->rng.nextFloat() * 2.0f * glm::pi<float>();
+                    bot->input.front = glm::vec3(cos(yaw), -0.26f, sin(yaw));
+                    bot->input.forward = bot->rng.nextFloat() < 0.8f;
+                    bot->turnTimer = 0.5f + bot->rng.nextFloat() * 1.5f;
+                }
+                bot->input.jump = bot->rng.nextFloat() < 0.01f;
+                bot->input.dash = bot->rng.nextFloat() < 0.005f;
+                bot->input.superJump = bot->rng.nextFloat() < 0.002f;
+                bot->client.update(bot->input, dt);
+            }
+            double t = GameServer::now();
+            if (t - lastReport >= 1.0) {
+                uint64_t bytes = 0, snaps = 0, dropped = 0, corrections = 0, teleports = 0;
+                int connected = 0, caught = 0;
+                double correction = 0.0;
+                for (auto& bot : bots) {
+                    bytes += bot->client.bytesIn; snaps += bot->client.snapshots; dropped += bot->client.dropped;
+                    connected += bot->client.connected ? 1 : 0; caught += bot->client.caught;
+                    correction += bot->client.correction; corrections += bot->client.corrections; teleports += bot->client.teleports;
+                }
+                double span = t - lastReport;
+                std::cout << "bots " << connected << "/" << botCount << " | in " << (bytes - lastBytes) / span / glm::max(connected, 1) / 1024.0
+                    << " KB/s/bot | snapshots " << (snaps - lastSnapshots) / span / glm::max(connected, 1) << " /s/bot | dropped " << dropped
+                    << " | avg prediction error " << (corrections ? correction / corrections * 1000.0 : 0.0) << " mm | respawns " << teleports << " | caught " << caught << std::endl;
+                lastBytes = bytes; lastSnapshots = snaps; lastReport = t;
+            }
+            next += dt;
+            double wait = next - GameServer::now();
+            if (wait > 0.0) std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        }
+        return 0;
+    }
+};
 
-    glm::mat4 getRollMatrix(Camera& cam) {
-        return glm::rotate(glm::mat4(1.0f), rollAngle, glm::vec3(0, 0, 1));
+// Seyirci kalabalığı: yakındakiler küp, uzaktakiler kameraya dönük billboard olarak instanced çizilir
+class SpectatorCrowd {
+public:
+    enum Lod { LOD_CUBE, LOD_BILLBOARD, LOD_COUNT };
+    const float maxScale = 1.2f, maxSpacing = 2.0f;
+    const float innerOffset = 0.8f, outerOffset = 2.2f; // Tribün şeridi: duvarın dış yüzünden uzaklık (dış duvar 2.5'te)
+    float baseHeight, innerRadius, outerRadius;
+    // Ekrandaki yükseklik (piksel) bu eşiğin altına inince billboard'a, üstüne çıkınca küpe geçer (histerezis)
+    const float toBillboardPixels = 28.0f, toCubePixels = 36.0f;
+
+    vector<glm::vec3> positions;
+    vector<glm::vec4> rest; // Dinlenme duruşu (x, taban yüksekliği, z, yaw): karede yalnızca y'ye zıplama eklenir
+    vector<float> jumpPhases;
+    vector<unsigned char> texIndex, lod, bucket;
+    vector<glm::vec4> instances; // xyz: pozisyon, w: yaw; [lod][texture] kovalarına göre sıralı
+    // Parça başına kova sayaçları: sınıflama ve doldurma işçilerde paralel, birleştirme tek önek toplamı
+    enum { CHUNK = 1024, BUCKETS = LOD_COUNT * 4, CULLED = 0xFF };
+    struct ChunkBuckets { GLsizei n[BUCKETS]; };
+    vector<ChunkBuckets> chunks;
+    GLsizei bucketStart[LOD_COUNT][4], bucketCount[LOD_COUNT][4];
+    Texture* textures[4];
+    TextureMesh billboard;
+    GLuint cubeVAO, billboardVAO;
+    size_t instanceOffset; // Bu karenin instance verisinin StreamBuffer içindeki konumu
+    GLsizei cubeIndexCount;
+    float scale, jumpTime;
+
+    SpectatorCrowd(const TextureMesh& cube, Texture& blue, Texture& yellow, Texture& red, Texture& green)
+        : baseHeight(ArenaMap::current().wallHeight + 0.7f), innerRadius(ArenaMap::current().boundRadius + innerOffset), outerRadius(ArenaMap::current().boundRadius + outerOffset),
+        textures{ &blue, &yellow, &red, &green }, billboard(createBillboardVerts(), { 0, 1, 2, 2, 3, 0 }),
+        instanceOffset(0), cubeIndexCount(static_cast<GLsizei>(cube.inds.size())), scale(maxScale), jumpTime(0.0f) {
+        cubeVAO = createInstancedVAO(cube);
+        billboardVAO = createInstancedVAO(billboard);
     }
 
-    void update(glm::vec3 playerPos, float dt, Wave& wave) {
-        if (stunTime > 0) {
-            stunTime -= dt;
-            if (stunTime < 0) stunTime = 0;
-            return;
+    static vector<GLfloat> createBillboardVerts() {
+        return { -0.5f,-0.5f,0.0f,0.0f,0.0f, 0.5f,-0.5f,0.0f,1.0f,0.0f, 0.5f,0.5f,0.0f,1.0f,1.0f, -0.5f,0.5f,0.0f,0.0f,1.0f };
+    }
+
+    // Mesh'in kendi VBO/EBO'sunu paylaşır, location 2'ye instance başına vec4 ekler (StreamBuffer'dan, çizimde bağlanır)
+    GLuint createInstancedVAO(const TextureMesh& mesh) {
+        GLuint vao;
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(2, 1);
+        glEnableVertexAttribArray(2);
+        glBindVertexArray(0);
+        return vao;
+    }
+
+    // Kalabalık büyüdükçe aralık (ve küp boyu) küçülür; halka tamamen doldurulup istenen sayıya düzgün seyreltilir
+    size_t place(size_t count, uint64_t seed) {
+        const float packing = 0.7f; // k=6 Bridson ile ~0.77 * alan / r^2 nokta sığar, az da olsa fazlası üretilsin
+        float area = glm::pi<float>() * (outerRadius * outerRadius - innerRadius * innerRadius);
+        float spacing = glm::min(maxSpacing, sqrt(packing * area / glm::max<float>(static_cast<float>(count), 1.0f)));
+        Rng rng(seed);
+        vector<glm::vec2> points;
+        size_t placed = PoissonDisk::sampleAnnulus(rng, innerRadius, outerRadius, spacing, SIZE_MAX, points);
+        for (size_t i = 0; i < count && i < placed; ++i) std::swap(points[i], points[i + rng.nextBelow(static_cast<uint32_t>(placed - i))]);
+        placed = std::min(placed, count);
+
+        scale = glm::min(maxScale, spacing);
+        positions.clear(); rest.clear(); jumpPhases.clear(); texIndex.clear(); lod.clear();
+        positions.reserve(placed); rest.reserve(placed); jumpPhases.reserve(placed); texIndex.reserve(placed); lod.reserve(placed);
+        // Daire halkasında örneklenen noktalar arenanın dış çizgisini izleyen şeride taşınır (dairesel arenada aynen kalır)
+        const ArenaMap& map = ArenaMap::current();
+        for (size_t i = 0; i < placed; ++i) {
+            float angle = atan2(points[i].y, points[i].x), r = glm::length(points[i]) - map.boundRadius + map.outlineRadius(angle);
+            add(glm::vec3(r * cos(angle), baseHeight, r * sin(angle)), rng.nextFloat(), rng.nextBelow(4));
         }
+        std::cout << "Spectators placed: " << placed << "/" << count << " (seed " << seed << ")" << std::endl;
+        return placed;
+    }
 
-        glm::vec3 dir = playerPos - pos;
-        float dist = glm::length(dir);
-        dir = glm::normalize(dir);
+    void add(const glm::vec3& pos, float phase, int tex) {
+        glm::vec3 toCenter = glm::normalize(-pos);
+        positions.push_back(pos);
+        jumpPhases.push_back(phase);
+        rest.push_back(glm::vec4(pos, atan2(toCenter.z, toCenter.x) + glm::pi<float>()));
+        texIndex.push_back(static_cast<unsigned char>(tex));
+        lod.push_back(LOD_CUBE);
+    }
 
-        if (wave.active) {
-            float waveDist = glm::length(wave.center - pos) - wave.radius;
-            if (waveDist <= 0) {
-                speed = 0;
-                return;
+    // Kare başına üç aşama (kare görev çizgesinde sırayla): classify ve fill işçilerde paralel, merge tek önek toplamı.
+    // Yükleme GL'e dokunduğu için render iş parçacığında, upload ile
+    void classify(float dt, const Camera& cam) {
+        jumpTime += dt * 2.0f;
+
+        // 1 birim yüksekliğin derinlik 1'deki piksel karşılığı
+        float pixelsPerUnit = cam.proj[1][1] * 0.5f * cam.h * scale;
+        size_t n = positions.size();
+        bucket.resize(n);
+        chunks.resize((n + CHUNK - 1) / CHUNK);
+
+        auto body = [&](size_t begin, size_t end) {
+            TRACE_SCOPE("crowd classify");
+            GLsizei* count = chunks[begin / CHUNK].n;
+            std::fill(count, count + BUCKETS, 0);
+            for (size_t i = begin; i < end; ++i) {
+                float depth = glm::dot(positions[i] - cam.pos, cam.front);
+                if (depth < -scale) { bucket[i] = CULLED; continue; } // Kameranın arkasında
+                float pixels = pixelsPerUnit / glm::max(depth, 0.1f);
+                if (lod[i] == LOD_CUBE && pixels < toBillboardPixels) lod[i] = LOD_BILLBOARD;
+                else if (lod[i] == LOD_BILLBOARD && pixels > toCubePixels) lod[i] = LOD_CUBE;
+                bucket[i] = static_cast<unsigned char>(lod[i] * 4 + texIndex[i]);
+                count[bucket[i]]++;
             }
-            else if (waveDist < 2.0f) {
-                dir = -dir;
-                speed = baseSpeed * 3.2f;
+            };
+        JobSystem::current().parallelFor(n, CHUNK, body);
+    }
+
+    void merge() {
+        // Kova içinde parça sırası korunur: çıktı seri sürümle ve iş parçacığı sayısından bağımsız olarak aynı
+        GLsizei offset = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            bucketStart[b / 4][b % 4] = offset;
+            for (ChunkBuckets& c : chunks) {
+                GLsizei count = c.n[b];
+                c.n[b] = offset;
+                offset += count;
             }
+            bucketCount[b / 4][b % 4] = offset - bucketStart[b / 4][b % 4];
         }
+        instances.resize(offset);
+    }
 
-        speed = (dist < 2.0f) ? baseSpeed * 2.0f :
-            (glm::length(playerPos - (pos - vel * dt)) > 5.0f) ? baseSpeed * 2.5f : baseSpeed;
+    void fill(const glm::vec3& playerPos) {
+        const float pi2 = 2.0f * glm::pi<float>();
+        auto body = [&](size_t begin, size_t end) {
+            TRACE_SCOPE("crowd fill");
+            GLsizei* cursor = chunks[begin / CHUNK].n;
+            for (size_t i = begin; i < end; ++i) {
+                if (bucket[i] == CULLED) continue;
+                float jump = sin((jumpPhases[i] + jumpTime) * pi2) * 0.2f;
+                float dist = glm::length(playerPos - positions[i]);
+                if (dist < 5.0f) jump += sin((jumpPhases[i] + jumpTime) * pi2 * 2.0f) * 0.3f * (1.0f - dist / 5.0f);
+                glm::vec4& inst = instances[cursor[bucket[i]]++];
+                inst = rest[i];
+                inst.y += jump;
+            }
+            };
+        JobSystem::current().parallelFor(positions.size(), CHUNK, body);
+    }
 
-        pos += dir * speed * dt;
-        pos.y = 0.5f;
+    void upload() {
+        if (!instances.empty()) instanceOffset = StreamBuffer::current().upload(instances.data(), instances.size() * sizeof(glm::vec4), sizeof(glm::vec4));
+    }
+
+    void draw(const Camera& cam, Shader& cubeShader, Shader& billboardShader) {
+        cubeShader.use();
+        cubeShader.setMat4("view", cam.view);
+        cubeShader.setMat4("projection", cam.proj);
+        cubeShader.setFloat("scale", scale);
+        glUniform1i(glGetUniformLocation(cubeShader.ID, "texture1"), 0);
+        drawBuckets(LOD_CUBE, cubeVAO, cubeIndexCount);
+
+        // Dik (y ekseni sabit) billboard: sağ vektör kameranın yatay sağı
+        glm::vec3 right = glm::normalize(glm::vec3(cam.view[0][0], 0.0f, cam.view[2][0]));
+        billboardShader.use();
+        billboardShader.setMat4("view", cam.view);
+        billboardShader.setMat4("projection", cam.proj);
+        billboardShader.setVec3("camRight", right);
+        billboardShader.setFloat("scale", scale);
+        glUniform1i(glGetUniformLocation(billboardShader.ID, "texture1"), 0);
+        drawBuckets(LOD_BILLBOARD, billboardVAO, static_cast<GLsizei>(billboard.inds.size()));
+    }
 
-        float radius = 10.0f;
-        float wallDist = glm::length(glm::vec2(pos.x, pos.z));
-        if (wallDist + 0.5f > radius - 0.5f) {
-            float angle = atan2(pos.z, pos.x);
-            pos.x = (radius - 1.0f) * cos(angle);
-            pos.z = (radius - 1.0f) * sin(angle);
+    void drawBuckets(int l, GLuint vao, GLsizei indexCount) {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, StreamBuffer::current().VBO);
+        for (int t = 0; t < 4; ++t) {
+            if (bucketCount[l][t] == 0) continue;
+            textures[t]->bind(GL_TEXTURE0);
+            glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)(instanceOffset + bucketStart[l][t] * sizeof(glm::vec4)));
+            glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, bucketCount[l][t]);
         }
+        glBindVertexArray(0);
+    }
 
-        rollAngle += 3.0f * dt;
+    ~SpectatorCrowd() {
+        glDeleteVertexArrays(1, &cubeVAO);
+        glDeleteVertexArrays(1, &billboardVAO);
     }
 };
 
 class Game {
 public:
     Window win;
-    Shader shader, waveShader, textShader, textureShader, uiShader, sliderShader;
+    Shader shader, waveShader, textShader, textureShader, uiShader, crowdShader, billboardShader, upscaleShader, particleUpdateShader, particleShader;
     Renderer render;
     Camera cam;
-    TextureMesh ground, wall, tribune, textureMesh, outerWall, spectatorCube;
-    Mesh cube, waveMesh, sliderBarMesh, sliderHandleMesh;
+    TextureMesh ground, wall, tribune, outerWall, pillars, spectatorCube;
+    Transform arenaXf, groundXf, wallXf; // Sabit arena parçaları: matrisleri ilk çizimde bir kez kurulur
+    Mesh cube, waveMesh;
     Texture dashTexture, superJumpTexture, arenaFloorTexture, arenaWallTexture, spectatorAreaTexture, SpectatorAreaUpperTexture, spectatorBlueTex, spectatorYellowTex, spectatorRedTex, spectatorGreenTex;
     Texture menuBackgroundTexture, playButtonTexture, hardnessTexture, story1Texture, story2Texture, story3Texture, story4Texture, settingsBackgroundTexture, keybindsTexture, lost1Texture;
-    Texture lost2Texture, win1Texture, win2Texture, win3Texture, win4Texture, win5Texture;
+    Texture lost2Texture, win1Texture, win2Texture, win3Texture, win4Texture, win5Texture, whiteTexture;
+    UIBatch uiBatch;
+    UIScreen menuUI, keybindsUI, settingsUI, difficultyUI, storyUI, hudUI, endUI;
+    size_t sensitivitySlider, storyImage, endImage, dashIcon, superJumpIcon;
+    SpectatorCrowd crowd;
     Player player;
     AI ai;
     Wave wave;
-    float gameTime, mouseSensitivity, sliderValue, sliderMin, sliderMax, sliderX, sliderY, sliderWidth, sliderHeight, handleWidth, handleHeight;
-    bool over, won, inMenu, inDifficultySelection, inStory, inSettings, mousePressed, spacePressed, dragging, inkeybinds;
+    FlowField flow;
+    float gameTime, mouseSensitivity, sliderValue, sliderMin, sliderMax;
+    bool over, won, inMenu, inDifficultySelection, inStory, inSettings, dragging, inkeybinds;
     int currentStoryPage, lostStoryPage, winStoryPage;
     enum Difficulty { EASY, HARD };
     Difficulty currentDifficulty;
     TextRenderer* text;
+    InputQueue input;
+    LatencyMonitor latency;
+    DynamicResolution dynres; // 3B geçişin ölçekli çözünürlüğü
+    ParticleSystem particles;
+    bool waveShown;           // Şok dalgası enkazı yalnızca dalganın başladığı karede patlar
+    bool showLatency;  // F3 ya da --latency
+    double frameCap;   // --fps-cap, 0 = sınırsız
+    FrameArena arena;  // Kare içi geçici veriler
+    bool allocCheck;   // --alloc-check: ısınmadan sonra heap'ten ayıran oyun karelerini raporla
+    int frameLimit;    // > 0 ise bu kadar kareden sonra çık
+    size_t allocFailures;
+    NetClient* net;   // --connect ile sunucuya bağlıysa
+    int netCaught;
+    uint32_t simTick;
+    bool caught;             // Yerel oyunda sürekli çarpışma testinin sonucu
+    glm::vec3 aiFrameStart;  // Dalga testinde kovalayıcının kare başı konumu
+    WorldState initialState;
+    StateRing<WorldState, 600> history; // Son ~10 saniye (60 FPS)
+    vector<DrawCmd> entityCmds;  // Ağ modunda uzak varlıkların çizimleri
+    TaskGraph frameGraph;        // Kare başına CPU hazırlığı: kalabalık aşamaları ve uzak varlık matrisleri
+    size_t spectatorCount;       // --spectators
+    float crowdMs;               // Kalabalık güncellemesinin CPU süresi (yumuşatılmış), F3'te
+    FrameCapture capture;        // --capture
+    const char* tracePath;       // F9 ya da --trace: son traceSeconds saniyenin izi
+    double traceSeconds;
+    bool traceOnExit;
+    double fixedStep;            // > 0 ise saat yerine sabit adım (ekransız, belirlenimci kayıt)
+    uint64_t seed;               // Seyirci yerleşimi; --seed ile sabitlenir
 
     Game() : win(800, 600, "Catch Me If You Can"),
-        shader(
-            // Vertex Shader
-            "#version 330 core\n"
-            "layout(location=0) in vec3 aPos;\n"
-            "uniform mat4 model,view,projection; void main() { gl_Position=projection*view*model*vec4(aPos,1.0); }\n",
-            // Fragment Shader
-            "#version 330 core\n"
-            "out vec4 FragColor;\n"
-            "uniform vec4 color; void main() { FragColor=color; }\n"
-        ),
-        waveShader(
-            // Vertex Shader
-            "#version 330 core\n"
-            "layout(location=0) in vec3 aPos;\n"
-            "uniform mat4 model,view,projection; void main() { gl_Position=projection*view*model*vec4(aPos,1.0); }\n",
-            // Fragment Shader
-            "#version 330 core\n"
-            "out vec4 FragColor;\n"
-            "uniform vec4 color; void main() { FragColor=color; }\n"
-        ),
-        textShader(
-            // Vertex Shader
-            "#version 330 core\n"
-            "layout(location=0) in vec4 vertex; out vec2 TexCoords;\n"
-            "uniform mat4 projection; void main() { gl_Position=projection*vec4(vertex.xy,0.0,1.0); TexCoords=vertex.zw; }\n",
-            // Fragment Shader
-            "#version 330 core\n"
-            "in vec2 TexCoords; out vec4 color; uniform sampler2D text;\n"
-            "uniform vec3 textColor; void main() { color=vec4(textColor,1.0)*vec4(1.0,1.0,1.0,texture(text,TexCoords).r); }\n"
-        ),
-        textureShader(
-            // Vertex Shader
-            "#version 330 core\n"
-            "layout(location=0) in vec3 aPos; layout(location=1) in vec2 aTexCoord; out vec2 TexCoord;\n"
-            "uniform mat4 model,view,projection; void main() { gl_Position=projection*view*model*vec4(aPos,1.0); TexCoord=aTexCoord; }\n",
-            // Fragment Shader
-            "#version 330 core\n"
-            "in vec2 TexCoord; out vec4 FragColor; uniform sampler2D texture1;\n"
-            "uniform vec4 colorTint; void main() { FragColor=texture(texture1,TexCoord)*colorTint; }\n"
-        ),
-        uiShader(
-            // Vertex Shader
-            "#version 330 core\n"
-            "layout(location=0) in vec2 aPos; layout(location=1) in vec2 aTexCoord; out vec2 TexCoord;\n"
-            "uniform mat4 model,projection; void main() { gl_Position=projection*model*vec4(aPos,0.0,1.0); TexCoord=aTexCoord; }\n",
-            // Fragment Shader
-            "#version 330 core\n"
-            "in vec2 TexCoord; out vec4 FragColor; uniform sampler2D texture1;\n"
-            "uniform vec4 colorTint; void main() { FragColor=texture(texture1,TexCoord)*colorTint; }\n"
-        ),
-        sliderShader(
-            // Vertex Shader
-            "#version 330 core\n"
-            "layout(location=0) in vec2 aPos;\n"
-            "uniform mat4 model,projection; void main() { gl_Position=projection*model*vec4(aPos,0.0,1.0); }\n",
-            // Fragment Shader
-            "#version 330 core\n"
-            "out vec4 FragColor;\n"
-            "uniform vec4 color; void main() { FragColor=color; }\n"
-        ),
+        shader("color"), waveShader("color"), textShader("text"), textureShader("texture"), uiShader("ui"), crowdShader("crowd"), billboardShader("billboard"), upscaleShader("upscale"),
+        particleUpdateShader("particle_update", { "outPosLife", "outVelKind" }), particleShader("particle"),
         render(),
-        cam(win.w, win.h), textureMesh(), player(glm::vec3(0.0f, 0.5f, 0.0f), true), ai(glm::vec3(8.0f, 0.5f, 8.0f)), wave(), gameTime(0.0f), over(false), won(false), inMenu(true),
+        cam(win.w, win.h), player(spawnPos(ArenaMap::current().playerSpawn), true), ai(spawnPos(ArenaMap::current().chaserSpawn)), wave(), gameTime(0.0f), over(false), won(false), inMenu(true),
         ground(createGroundVerts(), createGroundInds()), cube(createCubeVerts(), createCubeInds()), waveMesh(createWaveVerts(), createWaveInds()), wall(createWallVertsWithUV(), createWallInds()),
-        tribune(createTribuneVertsWithUV(), createTribuneInds()), outerWall(createOuterWallVertsWithUV(), createWallInds()), spectatorCube(createSpectatorCubeVerts(), createSpectatorCubeInds()),
+        tribune(createTribuneVertsWithUV(), createTribuneInds()), outerWall(createOuterWallVertsWithUV(), createWallInds()), pillars(createPillarVerts(), createPillarInds()), spectatorCube(createSpectatorCubeVerts(), createSpectatorCubeInds()),
         dashTexture("textures/dashfoto.png"), superJumpTexture("textures/superjumpfoto.png"), arenaFloorTexture("textures/ArenaFloor.png"), arenaWallTexture("textures/ArenaWall.png"),
         spectatorAreaTexture("textures/SpectatorArea.png"), SpectatorAreaUpperTexture("textures/SpectatorAreaUpper.png"), spectatorBlueTex("textures/SpectatorBlue.png"), spectatorYellowTex("textures/SpectatorYellow.png"),
         spectatorRedTex("textures/SpectatorRed.png"), spectatorGreenTex("textures/SpectatorGreen.png"), menuBackgroundTexture("textures/Mainmenu.png"), playButtonTexture("textures/playButton.png"),
         hardnessTexture("textures/Hardness.png"), story1Texture("textures/story1.png"), story2Texture("textures/story2.png"), story3Texture("textures/story3.png"), story4Texture("textures/story4.png"),
         settingsBackgroundTexture("textures/Settings.png"), keybindsTexture("textures/Keybinds.png"), lost1Texture("textures/Lost1.png"), lost2Texture("textures/Lost2.png"), win1Texture("textures/Win1.png"),
-        win2Texture("textures/Win2.png"), win3Texture("textures/Win3.png"), win4Texture("textures/Win4.png"), win5Texture("textures/Win5.png"), winStoryPage(0), lostStoryPage(0),
-        inDifficultySelection(false), inStory(false), inSettings(false), inkeybinds(false), currentStoryPage(0), mousePressed(false), spacePressed(false), currentDifficulty(EASY), text(new TextRenderer(&textShader)),
-        mouseSensitivity(0.5f), sliderValue(0.5f), sliderMin(0.1f), sliderMax(1.0f), sliderX(790.0f), sliderY(880.0f), sliderWidth(300.0f), sliderHeight(20.0f), handleWidth(20.0f), handleHeight(20.0f), dragging(false),
-        sliderBarMesh(createSliderBarVerts(), createSliderBarInds()), sliderHandleMesh(createSliderHandleVerts(), createSliderHandleInds()) {
+        win2Texture("textures/Win2.png"), win3Texture("textures/Win3.png"), win4Texture("textures/Win4.png"), win5Texture("textures/Win5.png"), whiteTexture(whitePixel(), 1, 1),
+        crowd(spectatorCube, spectatorBlueTex, spectatorYellowTex, spectatorRedTex, spectatorGreenTex), winStoryPage(0), lostStoryPage(0),
+        inDifficultySelection(false), inStory(false), inSettings(false), inkeybinds(false), currentStoryPage(0), currentDifficulty(EASY), text(new TextRenderer(&textShader)),
+        mouseSensitivity(Settings::current().mouseSensitivity), sliderValue(Settings::current().mouseSensitivity), sliderMin(0.1f), sliderMax(1.0f), dragging(false),
+        waveShown(false), showLatency(false), frameCap(0.0), arena(64 * 1024), allocCheck(false), frameLimit(0), allocFailures(0), net(nullptr), netCaught(0), simTick(0), caught(false), aiFrameStart(0.0f),
+        spectatorCount(Settings::current().quality.spectators), crowdMs(0.0f), tracePath("trace.json"), traceSeconds(10.0), traceOnExit(false), fixedStep(0.0), seed(static_cast<uint64_t>(time(nullptr))) {
 
         glfwSetInputMode(win.window, GLFW_CURSOR, GLFW_CURSOR_NORMAL); glEnable(GL_DEPTH_TEST); glEnable(GL_BLEND); glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        input.attach(win.window);
+        latency.init();
+        dynres.init(win.w, win.h);
+        const GLFWvidmode* vidmode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        if (vidmode && vidmode->refreshRate > 0) dynres.targetMs = 1000.0f / vidmode->refreshRate;
+        dynres.scale = dynres.maxScale = Settings::current().quality.renderScale;
+        groundXf.setPosition(glm::vec3(0.0f, -0.1f, 0.0f));
+        wallXf.setPosition(glm::vec3(0.0f, ArenaMap::current().wallHeight / 2, 0.0f));
+        groundXf.setParent(&arenaXf);
+        wallXf.setParent(&arenaXf);
+        buildUI();
+        entityCmds.reserve(NetWorld::MAX_PLAYERS + NetWorld::MAX_CHASERS);
+        initialState = snapshot();
+        cout << "Shaders: " << Shader::cacheHits << " from cache, " << Shader::compiled << " compiled, "
+            << Shader::buildSeconds * 1000.0 << " ms" << endl;
+    }
+
+    static glm::vec3 spawnPos(const glm::vec2& p) { return glm::vec3(p.x, 0.5f, p.y); }
+
+    static const unsigned char* whitePixel() {
+        static const unsigned char pixel[] = { 255, 255, 255, 255 };
+        return pixel;
+    }
+
+    // Ekranlar bir kez kurulur; her karede yalnızca değişen doku/renk/değer güncellenir
+    void buildUI() {
+        const glm::vec2 center(0.5f), bottomCenter(0.5f, 0.0f), origin(0.0f);
+        menuUI.background(menuBackgroundTexture);
+        menuUI.button(UI_PLAY, center, glm::vec2(-9.8f, 188.2f), glm::vec2(640.2f, 92.0f));
+        menuUI.button(UI_SETTINGS, center, glm::vec2(-9.8f, 41.2f), glm::vec2(640.2f, 92.0f));
+        menuUI.button(UI_QUIT, center, glm::vec2(-9.8f, -195.0f), glm::vec2(640.2f, 92.0f));
+
+        keybindsUI.background(keybindsTexture);
+        keybindsUI.button(UI_SETTINGS, center, glm::vec2(40.5f, -353.0f), glm::vec2(626.2f, 88.0f));
+
+        settingsUI.background(settingsBackgroundTexture);
+        sensitivitySlider = settingsUI.slider(UI_SENSITIVITY, origin, glm::vec2(940.0f, 880.0f), glm::vec2(300.0f, 20.0f), 1);
+        settingsUI.button(UI_MENU, center, glm::vec2(-32.5f, -210.0f), glm::vec2(626.2f, 88.0f));
+        settingsUI.button(UI_KEYBINDS, bottomCenter, glm::vec2(-32.0f, 618.0f), glm::vec2(626.0f, 88.0f));
+        settingsUI.button(UI_FULLSCREEN, origin, glm::vec2(666.5f, 715.0f), glm::vec2(147.0f, 920.0f));
+        settingsUI.button(UI_WINDOWED, origin, glm::vec2(1015.5f, 715.0f), glm::vec2(147.0f, 100.0f));
+
+        difficultyUI.background(hardnessTexture);
+        difficultyUI.button(UI_EASY, center, glm::vec2(-24.5f, 162.2f), glm::vec2(644.2f, 92.0f));
+        difficultyUI.button(UI_HARD, center, glm::vec2(-24.5f, 16.8f), glm::vec2(644.2f, 92.0f));
+        difficultyUI.button(UI_MENU, center, glm::vec2(-26.0f, -218.0f), glm::vec2(640.2f, 88.0f));
+
+        storyImage = storyUI.background(story1Texture);
+        endImage = endUI.background(lost1Texture);
+
+        dashIcon = hudUI.image(dashTexture, bottomCenter, glm::vec2(-215.0f, 135.0f), glm::vec2(0.0f), glm::vec2(250.0f));
+        superJumpIcon = hudUI.image(superJumpTexture, bottomCenter, glm::vec2(205.0f, 165.0f), glm::vec2(0.0f), glm::vec2(250.0f));
+    }
+
+    WorldState snapshot() const {
+        WorldState s;
+        s.tick = simTick;
+        s.gameTime = gameTime;
+        s.player = player.state();
+        s.ai = ai.state();
+        s.wave = wave.state();
+        s.flow = flow.state();
+        s.caught = caught;
+        return s;
+    }
+
+    void restore(const WorldState& s) {
+        simTick = s.tick;
+        gameTime = s.gameTime;
+        player.state() = s.player;
+        ai.state() = s.ai;
+        wave.state() = s.wave;
+        flow.restore(s.flow);
+        caught = s.caught;
+    }
+
+    // 3B sahne: dinamik çözünürlüklü FBO'ya çizilir, pencereye (ya da ekransız hedefe) büyütülür
+    void drawWorld(Wave& shownWave, float dt, double now) {
+        TRACE_SCOPE("render world");
+        auto draw3D = [&](TextureMesh& mesh, Texture& tex, const glm::mat4& model, glm::vec4 color = glm::vec4(1.0f)) {
+            textureShader.use();
+            render.drawTexture(mesh, textureShader, tex, model, cam.view, cam.proj, color, false);
+            };
+        // CPU hazırlığı kare görev çizgesinde, GL çağrıları sonra render iş parçacığında
+        if (crowd.positions.empty()) crowd.place(spectatorCount, seed);
+        double crowdStart = glfwGetTime();
+        auto classify = [&] { crowd.classify(dt, cam); };
+        auto merge = [&] { crowd.merge(); };
+        auto fill = [&] {
+            crowd.fill(player.pos);
+            crowdMs = crowdMs * 0.95f + static_cast<float>(glfwGetTime() - crowdStart) * 1000.0f * 0.05f;
+            };
+        auto entities = [&] { buildNetEntities(); };
+        frameGraph.clear();
+        int classifyTask = frameGraph.add("crowd classify", classify), mergeTask = frameGraph.add("crowd merge", merge), fillTask = frameGraph.add("crowd fill", fill);
+        bool built = classifyTask >= 0 && mergeTask >= 0 && fillTask >= 0 && (!net || frameGraph.add("entity draws", entities) >= 0)
+            && frameGraph.depend(mergeTask, classifyTask) && frameGraph.depend(fillTask, mergeTask);
+        if (built) frameGraph.run();
+        else {
+            // Çizge kurulamadı: aynı sırayla bu iş parçacığında
+            frameGraph.clear();
+            classify();
+            merge();
+            fill();
+            if (net) entities();
+        }
+
+        dynres.begin(win.w, win.h, now);
+        draw3D(ground, arenaFloorTexture, groundXf.world());
+        shader.use();
+        render.draw(cube, shader, cam.view, cam.proj, player.getModel(), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+        if (net) drawNetEntities();
+        else render.draw(cube, shader, cam.view, cam.proj, ai.getModel(), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+        draw3D(wall, arenaWallTexture, wallXf.world());
+        if (!pillars.inds.empty()) draw3D(pillars, arenaWallTexture, arenaXf.world());
+        draw3D(tribune, spectatorAreaTexture, arenaXf.world());
+        drawSpectators();
+        draw3D(outerWall, SpectatorAreaUpperTexture, arenaXf.world());
+        if (player.enableAbilities && shownWave.active) {
+            glDisable(GL_DEPTH_TEST);
+            render.draw(waveMesh, waveShader, cam.view, cam.proj, shownWave.getModel(), glm::vec4(0.0f, 1.0f, 0.0f, 0.5f));
+            glEnable(GL_DEPTH_TEST);
+        }
+        particles.update(particleUpdateShader, dt, now);
+        particles.draw(particleShader, cam.view, cam.proj, static_cast<float>(dynres.h), now);
+        dynres.end(upscaleShader, win.target);
+    }
+
+    // Kalite kıyaslaması, asıl oyunda menüden önce: ayardan bağımsız sabit standart sahne (tam kalabalık = ULTRA seyircisi,
+    // sürekli parçacık yayımı, ULTRA uzak düzlemi, sabit kamera yolu), dinamik çözünürlük kapalı ve takas yok (vsync ölçmez).
+    // Sahne tam ölçekte bütçenin yarısına (oyun mantığı, HUD ve dalgalanma payı) sığıyorsa ULTRA, bütçeye sığıyorsa HIGH
+    // (üçte bir kalabalık payı karşılar); değilse MEDIUM ve LOW ölçeklerinde aynı sahne ölçülür ve bütçeye sığan ilki seçilir.
+    QualitySettings::Preset benchmark(float targetMs) {
+        const int warmup = 10, frames = 60;
+        const QualitySettings full = QualitySettings::make(QualitySettings::ULTRA);
+        float scale = dynres.scale, minScale = dynres.minScale, maxScale = dynres.maxScale;
+        crowd.place(full.spectators, 1);
+        cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, full.farPlane);
+        auto measure = [&](float fixedScale) {
+            dynres.scale = dynres.minScale = dynres.maxScale = fixedScale;
+            double start = 0.0;
+            for (int i = 0; i < warmup + frames; ++i) {
+                if (i == warmup) { glFinish(); start = glfwGetTime(); }
+                double now = i * 0.016;
+                // Arenanın çevresinde tek tur; parçacıklar merkezde, oyun içi dalga enkazı yoğunluğunda
+                cam.yaw = 360.0f * i / frames;
+                cam.pitch = -15.0f;
+                cam.setTarget(glm::vec3(0.0f));
+                cam.updateView(0.016f);
+                particles.emit(ParticleSystem::DEBRIS, glm::vec3(0.0f), glm::vec3(0.0f, 3.0f, 0.0f), 2.0f, 1.0f, 2.0f, 500, now);
+                glBindFramebuffer(GL_FRAMEBUFFER, win.target);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                drawWorld(wave, 0.016f, now);
+            }
+            glFinish();
+            float ms = static_cast<float>((glfwGetTime() - start) * 1000.0 / frames);
+            cout << "Benchmark at " << static_cast<int>(fixedScale * 100.0f + 0.5f) << "% scale: " << ms << " ms/frame (target " << targetMs << " ms)" << endl;
+            return ms;
+        };
+
+        QualitySettings::Preset chosen = QualitySettings::LOW;
+        float ms = measure(1.0f);
+        if (ms <= targetMs * 0.5f) chosen = QualitySettings::ULTRA;
+        else if (ms <= targetMs) chosen = QualitySettings::HIGH;
+        else if (measure(QualitySettings::make(QualitySettings::MEDIUM).renderScale) <= targetMs) chosen = QualitySettings::MEDIUM;
+
+        // Oyun kendi ayarıyla başlar: kalabalık ilk karede yeniden yerleşir, ölçek ölçümü sıfırdan
+        crowd.positions.clear();
+        dynres.scale = scale;
+        dynres.minScale = minScale;
+        dynres.maxScale = maxScale;
+        dynres.costPerArea = 0.0f;
+        cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, cam.farPlane);
+        return chosen;
+    }
+
+    // Kıyaslamanın seçtiği ayarın oturumda hemen geçerli olan kısmı; mesh çözünürlüğü ve dokular sonraki açılışta
+    void applyQuality(const QualitySettings& q) {
+        spectatorCount = q.spectators;
+        dynres.maxScale = q.renderScale;
+        dynres.scale = glm::min(dynres.scale, dynres.maxScale);
+        cam.farPlane = q.farPlane;
+        cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, cam.farPlane);
+    }
+
+    // Oyun olaylarından parçacık yayımı; yalnızca uniform kuyruğuna yazar, asıl iş GPU'da
+    void emitEffects(const Wave& shownWave, float dt, double now) {
+        if (player.dashing) {
+            glm::vec3 back = glm::vec3(cam.front.x, 0.0f, cam.front.z) * -2.0f; // Dash kamera yönünde: iz arkaya savrulur
+            particles.emit(ParticleSystem::DASH, player.pos, back, 0.6f, 0.0f, 0.6f, static_cast<int>(dt * 6000.0f), now);
+        }
+        bool waveActive = player.enableAbilities && shownWave.active;
+        if (waveActive && !waveShown)
+            particles.emit(ParticleSystem::DEBRIS, shownWave.center, glm::vec3(0.0f, 4.0f, 0.0f), 3.0f, 0.3f, 2.5f, 12000, now);
+        if (waveActive) // Genişleyen cephe zeminden toz kaldırır
+            particles.emit(ParticleSystem::DEBRIS, shownWave.center, glm::vec3(0.0f, 1.5f, 0.0f), 1.0f, shownWave.radius, 1.0f, static_cast<int>(dt * 30000.0f), now);
+        waveShown = waveActive;
+    }
+
+    void restart() {
+        restore(initialState);
+        history.clear();
+        over = won = false;
+        inMenu = true;
+        winStoryPage = lostStoryPage = 0;
+        glfwSetInputMode(win.window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+        cam.firstMouse = true;
+    }
+
+    ~Game() { delete net; delete text; StreamBuffer::shutdown(); }
+
+    bool connect(const char* host, uint16_t port) {
+        net = new NetClient(player);
+        if (net->connect(host, port)) return true;
+        delete net;
+        net = nullptr;
+        return false;
+    }
+
+    // Sunucudan gelen diğer oyuncular (yeşil) ve ortak kovalayıcılar (mavi)
+    // Uzak oyuncu ve kovalayıcıların matrisleri işçilerde, dizin başına sabit yuvaya; gönderim render iş parçacığında
+    void buildNetEntities() {
+        if (!net->latest) { entityCmds.clear(); return; }
+        const NetWorld& world = *net->latest;
+        size_t count = world.playerCount + world.chaserCount;
+        entityCmds.resize(count);
+        int self = net->slot;
+        auto build = [&](size_t begin, size_t end) {
+            TRACE_SCOPE("entity draws");
+            AI remote(glm::vec3(0.0f));
+            for (size_t i = begin; i < end; ++i) {
+                DrawCmd& cmd = entityCmds[i];
+                if (i < world.playerCount) {
+                    const NetEntity& e = world.players[i];
+                    glm::vec3 p(NetCodec::dq(e.f[PF_POS_X], 1000.0f), NetCodec::dq(e.f[PF_POS_Y], 1000.0f), NetCodec::dq(e.f[PF_POS_Z], 1000.0f));
+                    bool shown = static_cast<int>(i) != self && (e.f[PF_FLAGS] & PFLAG_PRESENT);
+                    cmd.model = glm::translate(glm::mat4(1.0f), p);
+                    cmd.color = glm::vec4(0.0f, 1.0f, 0.0f, shown ? 1.0f : 0.0f);
+                }
+                else {
+                    NetCodec::applyChaser(world.chasers[i - world.playerCount], remote);
+                    cmd.model = glm::translate(glm::mat4(1.0f), remote.pos) * remote.getRollMatrix(cam);
+                    cmd.color = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+                }
+            }
+            };
+        JobSystem::current().parallelFor(count, 32, build);
     }
 
-    ~Game() { delete text; }
+    void drawNetEntities() {
+        render.submit(cube, shader, cam.view, cam.proj, entityCmds.data(), entityCmds.size());
+    }
 
+    // Arena geometrisi ArenaMap'in dış çizgisinden: zemin merkezden yelpaze, duvar/tribün/dış duvar çizginin kaydırılmış halkaları
     vector<GLfloat> createGroundVerts() {
+        const ArenaMap& map = ArenaMap::current();
         vector<GLfloat> verts = { 0.0f, 0.0f, 0.0f, 0.5f, 0.5f };
-        const int segments = 32;
-        const float radius = 10.0f, pi2 = 2.0f * glm::pi<float>();
-        for (int i = 0; i <= segments; ++i) {
-            float angle = pi2 * i / segments, c = cos(angle), s = sin(angle);
-            verts.insert(verts.end(), { radius * c, 0.0f, radius * s, (c + 1.0f) * 0.5f, (s + 1.0f) * 0.5f });
+        for (size_t i = 0; i <= map.outline.size(); ++i) {
+            const glm::vec2& v = map.outline[i % map.outline.size()];
+            verts.insert(verts.end(), { v.x, 0.0f, v.y, (v.x / map.boundRadius + 1.0f) * 0.5f, (v.y / map.boundRadius + 1.0f) * 0.5f });
         }
         return verts;
     }
 
-    vector<GLfloat> createWallVertsWithUV() {
+    // İç ve dış kaydırma arasında, yüksekliği y0..y1 olan kalın halka (createWallInds düzeninde)
+    vector<GLfloat> createRingWallVerts(float outer, float inner, float y0, float y1) {
+        const ArenaMap& map = ArenaMap::current();
         vector<GLfloat> verts;
-        const int segments = 32;
-        const float radius = 10.0f, height = 5.0f, thickness = 0.5f, pi2 = 2.0f * glm::pi<float>();
-        for (int i = 0; i <= segments; ++i) {
-            float angle = pi2 * i / segments, c = cos(angle), s = sin(angle), u = i / (float)segments;
-            float xo = radius * c, zo = radius * s, xi = (radius - thickness) * c, zi = (radius - thickness) * s;
-            verts.insert(verts.end(), { xo, -height / 2, zo, u, 0.0f, xo, height / 2, zo, u, 1.0f, xi, -height / 2, zi, u, 0.0f, xi, height / 2, zi, u, 1.0f });
+        size_t segments = map.outline.size();
+        for (size_t i = 0; i <= segments; ++i) {
+            glm::vec2 o = map.offset(i, outer), in = map.offset(i, inner);
+            float u = i / (float)segments;
+            verts.insert(verts.end(), { o.x, y0, o.y, u, 0.0f, o.x, y1, o.y, u, 1.0f, in.x, y0, in.y, u, 0.0f, in.x, y1, in.y, u, 1.0f });
         }
         return verts;
     }
 
+    vector<GLfloat> createWallVertsWithUV() {
+        const ArenaMap& map = ArenaMap::current();
+        return createRingWallVerts(0.0f, -map.wallThickness, -map.wallHeight / 2, map.wallHeight / 2);
+    }
+
     vector<GLfloat> createTribuneVertsWithUV() {
+        const ArenaMap& map = ArenaMap::current();
         vector<GLfloat> verts;
-        const int segments = 64;
-        const float radius = 10.0f, wallHeight = 4.7f, tribuneDepth = 3.0f, pi2 = 2.0f * glm::pi<float>();
-        for (int i = 0; i <= segments; ++i) {
-            float angle = pi2 * i / segments, c = cos(angle), s = sin(angle), u = i / (float)segments;
-            verts.insert(verts.end(), { radius * c, wallHeight, radius * s, u, 0.0f, (radius + tribuneDepth) * c, wallHeight, (radius + tribuneDepth) * s, u, 1.0f });
+        size_t segments = map.outline.size();
+        float height = map.wallHeight - 0.3f;
+        for (size_t i = 0; i <= segments; ++i) {
+            glm::vec2 in = map.offset(i, 0.0f), out = map.offset(i, map.standsDepth);
+            float u = i / (float)segments;
+            verts.insert(verts.end(), { in.x, height, in.y, u, 0.0f, out.x, height, out.y, u, 1.0f });
         }
         return verts;
     }
 
     vector<GLfloat> createOuterWallVertsWithUV() {
+        const ArenaMap& map = ArenaMap::current();
+        return createRingWallVerts(map.standsDepth, map.standsDepth - 0.5f, 0.0f, 2.0f * map.wallHeight);
+    }
+
+    // Tüm sütunlar tek mesh: yan yüzey ve üst kapak
+    vector<GLfloat> createPillarVerts() {
+        const int segments = Settings::current().quality.pillarSegments();
+        const float pi2 = 2.0f * glm::pi<float>();
         vector<GLfloat> verts;
-        const int segments = 32;
-        const float radius = 13.0f, height = 10.0f, thickness = 0.5f, pi2 = 2.0f * glm::pi<float>();
-        for (int i = 0; i <= segments; ++i) {
-            float angle = pi2 * i / segments, c = cos(angle), s = sin(angle), u = i / (float)segments;
-            float xo = radius * c, zo = radius * s, xi = (radius - thickness) * c, zi = (radius - thickness) * s;
-            verts.insert(verts.end(), { xo, 0.0f, zo, u, 0.0f, xo, height, zo, u, 1.0f, xi, 0.0f, zi, u, 0.0f, xi, height, zi, u, 1.0f });
+        for (const ArenaMap::Pillar& p : ArenaMap::current().pillars) {
+            for (int i = 0; i <= segments; ++i) {
+                float angle = pi2 * i / segments, c = cos(angle), s = sin(angle), u = i / (float)segments;
+                float x = p.center.x + p.radius * c, z = p.center.y + p.radius * s;
+                verts.insert(verts.end(), { x, 0.0f, z, u, 0.0f, x, p.height, z, u, 1.0f });
+            }
+            verts.insert(verts.end(), { p.center.x, p.height, p.center.y, 0.5f, 0.5f });
         }
         return verts;
     }
 
+    vector<GLuint> createPillarInds() {
+        const GLuint segments = Settings::current().quality.pillarSegments(), stride = (segments + 1) * 2 + 1;
+        vector<GLuint> inds;
+        for (GLuint k = 0; k < ArenaMap::current().pillars.size(); ++k) {
+            GLuint base = k * stride, top = base + stride - 1;
+            for (GLuint i = 0; i < segments; ++i) {
+                GLuint b = base + i * 2;
+                inds.insert(inds.end(), { b, b + 1, b + 2, b + 2, b + 1, b + 3, top, b + 3, b + 1 });
+            }
+        }
+        return inds;
+    }
+
     vector<GLfloat> createSpectatorCubeVerts() {
         return {
             -0.5f,-0.5f,-0.5f,0.0f,0.0f, 0.5f,-0.5f,-0.5f,1.0f,0.0f, 0.5f,0.5f,-0.5f,1.0f,1.0f, -0.5f,0.5f,-0.5f,0.0f,1.0f,
@@ -833,15 +5482,14 @@ public:
 
     vector<GLuint> createGroundInds() {
         vector<GLuint> inds;
-        const GLuint segments = 32;
+        const GLuint segments = static_cast<GLuint>(ArenaMap::current().outline.size());
         for (GLuint i = 0; i < segments; ++i) inds.insert(inds.end(), { 0, i + 1, i + 2 });
-        inds.insert(inds.end(), { 0, segments + 1, 1 });
         return inds;
     }
 
     vector<GLuint> createTribuneInds() {
         vector<GLuint> inds;
-        const GLuint segments = 64;
+        const GLuint segments = static_cast<GLuint>(ArenaMap::current().outline.size());
         for (GLuint i = 0; i < segments; ++i) {
             GLuint b = i * 2;
             inds.insert(inds.end(), { b, b + 1, b + 2, b + 2, b + 1, b + 3 });
@@ -851,7 +5499,7 @@ public:
 
     vector<GLuint> createWallInds() {
         vector<GLuint> inds;
-        const GLuint segments = 32;
+        const GLuint segments = static_cast<GLuint>(ArenaMap::current().outline.size());
         for (GLuint i = 0; i < segments; ++i) {
             GLuint b = i * 4;
             inds.insert(inds.end(), { b,b + 1,b + 5, b + 5,b + 4,b, b + 2,b + 6,b + 3, b + 6,b + 7,b + 3, b + 1,b + 3,b + 7, b + 7,b + 5,b + 1, b,b + 4,b + 2, b + 4,b + 6,b + 2 });
@@ -870,7 +5518,7 @@ public:
 
     vector<GLfloat> createWaveVerts() {
         vector<GLfloat> verts;
-        const int segments = 64;
+        const int segments = Settings::current().quality.circleSegments;
         const float radius = 1.0f, thickness = 0.1f, pi2 = 2.0f * glm::pi<float>();
         for (int i = 0; i <= segments; ++i) {
             float angle = pi2 * i / segments, c = cos(angle), s = sin(angle);
@@ -881,7 +5529,7 @@ public:
 
     vector<GLuint> createWaveInds() {
         vector<GLuint> inds;
-        const GLuint segments = 64;
+        const GLuint segments = Settings::current().quality.circleSegments;
         for (GLuint i = 0; i < segments; ++i) {
             GLuint b = i * 2;
             inds.insert(inds.end(), { b, b + 1, b + 2, b + 2, b + 1, b + 3 });
@@ -889,88 +5537,87 @@ public:
         return inds;
     }
 
-    vector<GLfloat> createSliderBarVerts() {
-        return { 0.0f,0.0f,0.0f, 300.0f,0.0f,0.0f, 300.0f,20.0f,0.0f, 0.0f,20.0f,0.0f };
-    }
-
-    vector<GLuint> createSliderBarInds() {
-        return { 0,1,2, 2,3,0 };
-    }
-
-    vector<GLfloat> createSliderHandleVerts() {
-        return { -10.0f,-10.0f,0.0f, 10.0f,-10.0f,0.0f, 10.0f,10.0f,0.0f, -10.0f,10.0f,0.0f };
+    void drawSpectators() {
+        TRACE_SCOPE("drawSpectators");
+        crowd.upload();
+        crowd.draw(cam, crowdShader, billboardShader);
     }
 
-    vector<GLuint> createSliderHandleInds() {
-        return { 0,1,2, 2,3,0 };
-    }
-
-    void drawSpectators(float dt) {
-        const int count = 50;
-        const float radius = 11.5f, baseHeight = 5.7f, minDist = 2.0f, pi2 = 2.0f * glm::pi<float>();
-        static vector<glm::vec3> positions;
-        static vector<float> jumpPhases;
-        static vector<Texture*> textures;
-
-        if (positions.empty()) {
-            srand(static_cast<unsigned>(time(nullptr)));
-            for (int i = 0; i < count; ++i) {
-                glm::vec3 pos;
-                for (int j = 0; j < 100; ++j) {
-                    float angle = static_cast<float>(rand()) / RAND_MAX * pi2;
-                    float offset = -0.5f + static_cast<float>(rand()) / RAND_MAX;
-                    pos = { radius * cos(angle) + offset, baseHeight, radius * sin(angle) + offset };
-                    bool valid = true;
-                    for (const auto& p : positions) {
-                        if (glm::distance(pos, p) < minDist) {
-                            valid = false;
-                            break;
-                        }
-                    }
-                    if (valid) {
-                        positions.push_back(pos);
-                        jumpPhases.push_back(static_cast<float>(rand()) / RAND_MAX);
-                        int tex = rand() % 4;
-                        textures.push_back(tex == 0 ? &spectatorBlueTex : tex == 1 ? &spectatorYellowTex : tex == 2 ? &spectatorRedTex : &spectatorGreenTex);
-                        break;
-                    }
-                }
-            }
-        }
-
-        static float jumpTime = 0.0f;
-        jumpTime += dt * 2.0f;
-        for (size_t i = 0; i < positions.size(); ++i) {
-            float jump = sin((jumpPhases[i] + jumpTime) * pi2) * 0.2f;
-            glm::vec3 pos = positions[i];
-            pos.y = baseHeight + jump;
-            float dist = glm::length(player.pos - pos);
-            if (dist < 5.0f) {
-                jump += sin((jumpPhases[i] + jumpTime) * pi2 * 2.0f) * 0.3f * (1.0f - dist / 5.0f);
-                pos.y = baseHeight + jump;
-            }
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
-            model = glm::scale(model, glm::vec3(1.2f));
-            glm::vec3 toCenter = glm::normalize(-pos);
-            model = glm::rotate(model, atan2(toCenter.z, toCenter.x) + pi2 / 2.0f, { 0.0f, 1.0f, 0.0f });
-            render.drawTexture(spectatorCube, textureShader, *textures[i], model, cam.view, cam.proj, glm::vec4(1.0f), false);
+    // Düğme eylemleri; ekran değiştiyse true döner
+    bool uiAction(UIAction action, GLFWmonitor* monitor, const GLFWvidmode* mode) {
+        switch (action) {
+        case UI_PLAY: inMenu = false; inDifficultySelection = true; return true;
+        case UI_SETTINGS: inMenu = inkeybinds = false; inSettings = true; return true;
+        case UI_QUIT: glfwDestroyWindow(win.window); glfwTerminate(); exit(0);
+        case UI_MENU: inSettings = inDifficultySelection = false; inMenu = true; return true;
+        case UI_KEYBINDS: inSettings = false; inkeybinds = true; return true;
+        case UI_EASY:
+        case UI_HARD:
+            currentDifficulty = action == UI_EASY ? EASY : HARD;
+            player.enableAbilities = action == UI_EASY;
+            inDifficultySelection = false; inStory = true; currentStoryPage = 1;
+            return true;
+        case UI_FULLSCREEN:
+            glfwSetWindowMonitor(win.window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
+            glViewport(0, 0, win.w = cam.w = mode->width, win.h = cam.h = mode->height);
+            cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, cam.farPlane);
+            return true;
+        case UI_WINDOWED:
+            glfwSetWindowMonitor(win.window, nullptr, 100, 100, 800, 600, 0);
+            glViewport(0, 0, win.w = cam.w = 800, win.h = cam.h = 600);
+            cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, cam.farPlane);
+            return true;
+        case UI_SENSITIVITY: dragging = true; return false;
+        default: return false;
         }
     }
 
     void run() {
-        double lastTime = glfwGetTime(), lastFTime = 0.0;
+        double lastTime = glfwGetTime();
         GLFWmonitor* monitor = glfwGetPrimaryMonitor();
         const GLFWvidmode* mode = glfwGetVideoMode(monitor);
         bool fullscreen = false;
-
-        while (!win.shouldClose()) {
-            float dt = static_cast<float>(glfwGetTime() - lastTime);
-            lastTime = glfwGetTime();
+        int frame = 0, gameplayFrames = 0;
+#ifndef NDEBUG
+        double lastShaderCheck = lastTime;
+#endif
+
+        while (!win.shouldClose() && (frameLimit <= 0 || frame < frameLimit)) {
+            if (frameCap > 0.0) {
+                // Uyuma karenin başında: girdiler uykudan sonra okunur, sınır gecikmeye eklenmez
+                double until = lastTime + 1.0 / frameCap;
+                while (glfwGetTime() < until - 0.002) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                while (glfwGetTime() < until) {}
+                win.poll();
+            }
+            TRACE_SCOPE("frame");
+            double frameStart = lastTime;
+            lastTime = fixedStep > 0.0 ? frameStart + fixedStep : glfwGetTime();
+            float dt = static_cast<float>(lastTime - frameStart);
+            arena.reset();
+            Transform::rebuilds() = 0;
+            size_t allocsAtStart = heapAllocCount.load(std::memory_order_relaxed);
+            bool gameplayFrame = !inMenu && !inkeybinds && !inSettings && !inDifficultySelection && !inStory && !over;
+            {
+                TRACE_SCOPE("input");
+                input.beginFrame();
+                latency.beginFrame(input, lastTime);
+            }
+            if (input.pressed(GLFW_KEY_F3)) showLatency = !showLatency;
+            if (input.pressed(GLFW_KEY_F9) && Trace::dump(tracePath, traceSeconds)) cout << "Trace: last " << traceSeconds << " s written to " << tracePath << endl;
+#ifndef NDEBUG
+            // Geliştirme derlemesi: shaders/ altındaki dosyalar kaydedildikçe yeniden derlenir
+            if (lastTime - lastShaderCheck > 0.5) {
+                lastShaderCheck = lastTime;
+                Shader* all[] = { &shader, &waveShader, &textShader, &textureShader, &uiShader, &crowdShader, &billboardShader, &upscaleShader, &particleUpdateShader, &particleShader };
+                for (Shader* sh : all) sh->reloadIfChanged();
+            }
+#endif
+            glBindFramebuffer(GL_FRAMEBUFFER, win.target);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
             // Fullscreen toggle
-            if (glfwGetKey(win.window, GLFW_KEY_F) == GLFW_PRESS && glfwGetTime() - lastFTime > 0.5) {
-                lastFTime = glfwGetTime();
+            if (input.pressed(GLFW_KEY_F)) {
                 fullscreen = !fullscreen;
                 if (fullscreen) {
                     glfwSetWindowMonitor(win.window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
@@ -980,263 +5627,309 @@ public:
                     glfwSetWindowMonitor(win.window, nullptr, 100, 100, 800, 600, 0);
                     glViewport(0, 0, win.w = cam.w = 800, win.h = cam.h = 600);
                 }
-                cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, 100.0f);
+                cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, cam.farPlane);
             }
 
             glm::mat4 proj = glm::ortho(0.0f, (float)win.w, 0.0f, (float)win.h);
-            auto drawUI = [&](Texture& tex, float x, float y, float w, float h, bool interact = false, std::function<void()> action = [] {}) {
-                glm::mat4 model = interact ? glm::mat4(0.0f) : // Butonlar için sıfır matris (görünmez)
-                    glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f)), glm::vec3(w / 250.0f, h / 250.0f, 1.0f));
-                uiShader.use();
-                tex.bind(GL_TEXTURE0);
-                render.drawTexture(textureMesh, uiShader, tex, model, glm::mat4(1.0f), proj, glm::vec4(1.0f), true);
-                if (interact && glfwGetMouseButton(win.window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !mousePressed) {
-                    double mx, my;
-                    glfwGetCursorPos(win.window, &mx, &my);
-                    my = win.h - my;
-                    if (mx >= x - w / 2 && mx <= x + w / 2 && my >= y - h / 2 && my <= y + h / 2) {
-                        mousePressed = true;
-                        action();
-                    }
+            UIScreen* screen = inMenu ? &menuUI : inkeybinds ? &keybindsUI : inSettings ? &settingsUI :
+                inDifficultySelection ? &difficultyUI : inStory ? &storyUI : nullptr;
+
+            if (screen) {
+                TRACE_SCOPE("menu");
+                Texture* pages[] = { nullptr, &story1Texture, &story2Texture, &story3Texture, &story4Texture };
+                if (inStory) storyUI.widgets[storyImage].tex = currentStoryPage >= 1 && currentStoryPage <= 4 ? pages[currentStoryPage] : nullptr;
+                screen->layout(win.w, win.h);
+                float cx, cy;
+                while (input.popClick(win.h, cx, cy)) {
+                    int hit = screen->hit(cx, cy);
+                    if (hit >= 0 && uiAction(screen->widgets[hit].action, monitor, mode)) break; // Ekran değişti; kalan tıklamalar eski ekrana aitti
                 }
-                };
-
-            if (inMenu) {
-                glDisable(GL_DEPTH_TEST);
-                drawUI(menuBackgroundTexture, win.w / 2.0f, win.h / 2.0f, (float)win.w, (float)win.h);
-                drawUI(playButtonTexture, win.w / 2.0f - 9.8f, win.h / 2.0f + 188.2f, 640.2f, 92.0f, true, [&] { inMenu = false; inDifficultySelection = true; });
-                drawUI(playButtonTexture, win.w / 2.0f - 9.8f, win.h / 2.0f + 41.2f, 640.2f, 92.0f, true, [&] { inMenu = false; inSettings = true; });
-                drawUI(playButtonTexture, win.w / 2.0f - 9.8f, win.h / 2.0f - 195.0f, 640.2f, 92.0f, true, [&] { glfwDestroyWindow(win.window); glfwTerminate(); exit(0); });
-                if (glfwGetMouseButton(win.window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) mousePressed = false;
-                glEnable(GL_DEPTH_TEST);
-            }
-            else if (inkeybinds) {
-                glDisable(GL_DEPTH_TEST);
-                drawUI(keybindsTexture, win.w / 2.0f, win.h / 2.0f, (float)win.w, (float)win.h);
-                drawUI(playButtonTexture, win.w / 2.0f + 40.5f, win.h / 2.0f - 353.0f, 626.2f, 88.0f, true, [&] { inkeybinds = false; inSettings = true; });
-                if (glfwGetMouseButton(win.window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) mousePressed = false;
-                glEnable(GL_DEPTH_TEST);
-            }
-            else if (inSettings) {
-                glDisable(GL_DEPTH_TEST);
-                drawUI(settingsBackgroundTexture, win.w / 2.0f, win.h / 2.0f, (float)win.w, (float)win.h);
-                // Slider bar
-                glm::mat4 sliderModel = glm::translate(glm::mat4(1.0f), glm::vec3(sliderX, sliderY, 0.0f));
-                sliderShader.use();
-                sliderShader.setMat4("model", sliderModel);
-                sliderShader.setMat4("projection", proj);
-                sliderShader.setVec4("color", glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
-                render.draw(sliderBarMesh, sliderShader, glm::mat4(1.0f), proj, sliderModel, glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
-                // Slider handle
-                float handleX = sliderX + (sliderValue * sliderWidth) - handleWidth / 2.0f;
-                glm::mat4 handleModel = glm::translate(glm::mat4(1.0f), glm::vec3(handleX, sliderY + 10.1f, 1.0f));
-                sliderShader.setMat4("model", handleModel);
-                sliderShader.setMat4("projection", proj);
-                sliderShader.setVec4("color", glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
-                render.draw(sliderHandleMesh, sliderShader, glm::mat4(1.0f), proj, handleModel, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
-                // Buttons
-                drawUI(playButtonTexture, win.w / 2.0f - 32.5f, win.h / 2.0f - 210.0f, 626.2f, 88.0f, true, [&] { inSettings = false; inMenu = true; });
-                drawUI(playButtonTexture, win.w / 2.0f - 32.0f, 618.0f, 626.0f, 88.0f, true, [&] { inkeybinds = true; inSettings = false; });
-                // Fullscreen buttons
-                double mx, my;
-                glfwGetCursorPos(win.window, &mx, &my);
-                my = win.h - my;
-                auto drawColorButton = [&](float x, float y, float w, float h, glm::vec4 color, std::function<void()> action) {
-                    glm::mat4 model = glm::mat4(0.0f); // Görünmez yapmak için sıfır matris
-                    sliderShader.use();
-                    sliderShader.setMat4("model", model);
-                    sliderShader.setMat4("projection", proj);
-                    sliderShader.setVec4("color", color);
-                    render.draw(sliderBarMesh, sliderShader, glm::mat4(1.0f), proj, model, color);
-                    if (glfwGetMouseButton(win.window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !mousePressed &&
-                        mx >= x - w / 2 && mx <= x + w / 2 && my >= y - h / 2 && my <= y + h / 2) {
-                        mousePressed = true;
-                        action();
+                if (inSettings) {
+                    const glm::vec4& bar = settingsUI.widgets[sensitivitySlider].rect;
+                    if (dragging) {
+                        sliderValue = glm::clamp((float)(input.mouseX - (bar.x - bar.z / 2)) / bar.z, sliderMin, sliderMax);
+                        cam.mouseSensitivity = sliderValue;
+                    }
+                    if (!input.buttonHeld(GLFW_MOUSE_BUTTON_LEFT)) {
+                        if (dragging) { // Bırakınca oyunda da geçerli olur ve kaydedilir
+                            mouseSensitivity = Settings::current().mouseSensitivity = sliderValue;
+                            Settings::current().save();
+                        }
+                        dragging = false;
+                    }
+                    settingsUI.widgets[sensitivitySlider].value = sliderValue;
+                    if (input.pressed(GLFW_KEY_Q)) {
+                        // CUSTOM da döngüde: değerleri ayrılırken saklanır, dönünce geri gelir
+                        Settings& settings = Settings::current();
+                        if (settings.quality.preset == QualitySettings::CUSTOM) settings.custom = settings.quality;
+                        QualitySettings::Preset next = static_cast<QualitySettings::Preset>((settings.quality.preset + 1) % (QualitySettings::CUSTOM + 1));
+                        settings.quality = next == QualitySettings::CUSTOM ? settings.custom : QualitySettings::make(next);
+                        settings.quality.preset = next;
+                        settings.save();
                     }
-                    };
-                drawColorButton(666.5f, 715.0f, 147.0f, 920.0f, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), [&] {
-                    glfwSetWindowMonitor(win.window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
-                    glViewport(0, 0, win.w = cam.w = mode->width, win.h = cam.h = mode->height);
-                    cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, 100.0f);
-                    });
-                drawColorButton(1015.5f, 715.0f, 147.0f, 100.0f, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), [&] {
-                    glfwSetWindowMonitor(win.window, nullptr, 100, 100, 800, 600, 0);
-                    glViewport(0, 0, win.w = cam.w = 800, win.h = cam.h = 600);
-                    cam.proj = glm::perspective(glm::radians(45.0f), (float)win.w / win.h, 0.1f, 100.0f);
-                    });
-                // Slider interaction
-                if (glfwGetMouseButton(win.window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS && !mousePressed &&
-                    mx >= sliderX && mx <= sliderX + sliderWidth && my >= sliderY - sliderHeight / 2.0f && my <= sliderY + sliderHeight / 2.0f) {
-                    mousePressed = dragging = true;
                 }
-                if (dragging) {
-                    sliderValue = glm::clamp((float)(mx - sliderX) / sliderWidth, (float)sliderMin, (float)sliderMax);
-                    cam.mouseSensitivity = sliderValue;
+                screen->draw(uiBatch, whiteTexture);
+                uiBatch.flush(uiShader, proj);
+                if (inSettings) {
+                    glDisable(GL_DEPTH_TEST);
+                    text->draw(arena.format("Quality: %s (Q to change, applies after restart)", QualitySettings::name(Settings::current().quality.preset)),
+                        20.0f, 20.0f, 0.4f, glm::vec3(1.0f));
+                    glEnable(GL_DEPTH_TEST);
                 }
-                if (glfwGetMouseButton(win.window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) mousePressed = dragging = false;
-                glEnable(GL_DEPTH_TEST);
-            }
-            else if (inDifficultySelection) {
-                glDisable(GL_DEPTH_TEST);
-                drawUI(hardnessTexture, win.w / 2.0f, win.h / 2.0f, (float)win.w, (float)win.h);
-                drawUI(playButtonTexture, win.w / 2.0f - 24.5f, win.h / 2.0f + 162.2f, 644.2f, 92.0f, true, [&] {
-                    currentDifficulty = EASY; player.enableAbilities = true; inDifficultySelection = false; inStory = true; currentStoryPage = 1;
-                    });
-                drawUI(playButtonTexture, win.w / 2.0f - 24.5f, win.h / 2.0f + 16.8f, 644.2f, 92.0f, true, [&] {
-                    currentDifficulty = HARD; player.enableAbilities = false; inDifficultySelection = false; inStory = true; currentStoryPage = 1;
-                    });
-                drawUI(playButtonTexture, win.w / 2.0f - 26.0f, win.h / 2.0f - 218.0f, 640.2f, 88.0f, true, [&] { inDifficultySelection = false; inMenu = true; });
-                if (glfwGetMouseButton(win.window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) mousePressed = false;
-                glEnable(GL_DEPTH_TEST);
-            }
-            else if (inStory) {
-                glDisable(GL_DEPTH_TEST);
-                Texture* storyTex = nullptr;
-                if (currentStoryPage == 1) storyTex = &story1Texture;
-                else if (currentStoryPage == 2) storyTex = &story2Texture;
-                else if (currentStoryPage == 3) storyTex = &story3Texture;
-                else if (currentStoryPage == 4) storyTex = &story4Texture;
-                if (storyTex) drawUI(*storyTex, win.w / 2.0f, win.h / 2.0f, (float)win.w, (float)win.h);
-                if (glfwGetKey(win.window, GLFW_KEY_SPACE) == GLFW_PRESS && !spacePressed) {
-                    spacePressed = true;
+
+                if (inStory && input.pressed(GLFW_KEY_SPACE)) {
                     if (++currentStoryPage > 4) {
                         inStory = false;
                         glfwSetInputMode(win.window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
                         cam.firstMouse = true;
                     }
                 }
-                if (glfwGetKey(win.window, GLFW_KEY_SPACE) == GLFW_RELEASE) spacePressed = false;
-                glEnable(GL_DEPTH_TEST);
             }
             else if (!over) {
                 gameTime += dt;
-                double mx, my;
-                glfwGetCursorPos(win.window, &mx, &my);
-                cam.mouseInput(win, mx, my);
+                cam.mouseInput(win, input.mouseX, input.mouseY);
                 cam.mouseSensitivity = mouseSensitivity;
-                player.update(win, cam, dt);
-                ai.update(player.pos, dt, wave);
+                if (net) {
+                    // Ağ modu: simülasyon sunucuda, burada yalnızca yerel oyuncu tahmin edilir
+                    if (gameTime <= dt) netCaught = net->caught;
+                    net->update(input.playerInput(cam.front, static_cast<float>(lastTime)), dt);
+                }
+                else {
+                    TRACE_SCOPE("simulation");
+                    // Tuş olaylarının anlarında dilimle: kısa basışlar kaybolmaz, tepki kare başını beklemez
+                    aiFrameStart = ai.pos;
+                    input.replay(frameStart, lastTime, cam.front, [&](const PlayerInput& in, float stepDt) {
+                        if (caught) return;
+                        glm::vec3 p0 = player.pos, a0 = ai.pos;
+                        player.update(in, stepDt);
+                        flow.update(player.pos, stepDt, wave);
+                        ai.update(player.pos, stepDt, wave, flow);
+                        ai.confine();
+                        float toi;
+                        if (Sweep::spheres(p0, player.pos, a0, ai.pos, Sweep::catchRadius, toi)) {
+                            // Yakalanma anına geri al: bitiş ekranı temas anını gösterir
+                            caught = true;
+                            player.pos = glm::mix(p0, player.pos, toi);
+                            ai.pos = glm::mix(a0, ai.pos, toi);
+                        }
+                        });
+                }
                 cam.setTarget(player.pos);
                 cam.updateView(dt);
 
-                if (player.getWaveTriggered()) {
-                    wave.center = player.pos;
-                    wave.radius = 0.0f;
-                    wave.active = true;
-                    player.resetWave();
-                }
-                if (wave.active && glm::length(wave.center - ai.pos) <= wave.radius) ai.stunTime = 2.0f;
-                wave.update(dt);
-
-                auto draw3D = [&](TextureMesh& mesh, Texture& tex, glm::mat4 model, glm::vec4 color = glm::vec4(1.0f)) {
-                    textureShader.use();
-                    render.drawTexture(mesh, textureShader, tex, model, cam.view, cam.proj, color, false);
-                    };
-                draw3D(ground, arenaFloorTexture, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f)));
-                shader.use();
-                render.draw(cube, shader, cam.view, cam.proj, glm::translate(glm::mat4(1.0f), player.pos) * player.getRollMatrix(cam, win), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
-                render.draw(cube, shader, cam.view, cam.proj, glm::translate(glm::mat4(1.0f), ai.pos) * ai.getRollMatrix(cam), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
-                for (int i = 0; i < 32; ++i) draw3D(wall, arenaWallTexture, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 2.5f, 0.0f)));
-                draw3D(tribune, spectatorAreaTexture, glm::mat4(1.0f));
-                drawSpectators(dt);
-                for (int i = 0; i < 32; ++i) draw3D(outerWall, SpectatorAreaUpperTexture, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f)));
-                if (player.enableAbilities && wave.active) {
-                    glDisable(GL_DEPTH_TEST);
-                    waveShader.use();
-                    waveShader.setMat4("model", wave.getModel());
-                    waveShader.setMat4("view", cam.view);
-                    waveShader.setMat4("projection", cam.proj);
-                    waveShader.setVec4("color", glm::vec4(0.0f, 1.0f, 0.0f, 0.5f));
-                    render.draw(waveMesh, waveShader, cam.view, cam.proj, wave.getModel(), glm::vec4(0.0f, 1.0f, 0.0f, 0.5f));
-                    glEnable(GL_DEPTH_TEST);
+                if (!net) {
+                    if (player.getWaveTriggered()) {
+                        wave.center = player.pos;
+                        wave.radius = 0.0f;
+                        wave.active = true;
+                        player.resetWave();
+                    }
+                    if (wave.active) {
+                        float r0 = wave.radius, toi;
+                        wave.update(dt);
+                        if (Sweep::ring(wave.center, r0, std::min(wave.radius, wave.maxRadius), aiFrameStart, ai.pos, toi)) ai.stunTime = 2.0f;
+                    }
+                    ++simTick;
+                    history.push(snapshot());
                 }
-                if (glm::length(player.pos - ai.pos) < 1.15f) {
+
+                Wave& shownWave = net ? net->wave : wave;
+                emitEffects(shownWave, dt, lastTime);
+                drawWorld(shownWave, dt, lastTime);
+                if (net ? net->caught != netCaught : caught) {
                     over = true;
                     won = false;
+                    particles.emit(ParticleSystem::SPARK, (player.pos + ai.pos) * 0.5f, glm::vec3(0.0f, 3.0f, 0.0f), 4.0f, 0.0f, 1.5f, 4000, lastTime);
                     cout << "Yakalandın!\n";
                 }
                 else if (gameTime >= 60.0f) {
                     over = true;
                     won = true;
+                    particles.emit(ParticleSystem::CONFETTI, cam.pos + cam.front * 4.0f + glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 3.0f, 0.0f, 6.0f, 20000, lastTime);
                     cout << "Kazandın! 60 saniye hayatta kaldın!\n";
                 }
                 glDisable(GL_DEPTH_TEST);
                 textShader.use();
                 textShader.setMat4("projection", proj);
                 int timeLeft = std::max(0, static_cast<int>(60.0f - gameTime));
-                text->draw("Time: " + to_string(timeLeft) + "s", win.w - 200.0f, win.h - 50.0f, 0.5f, glm::vec3(1.0f));
+                text->draw(arena.format("Time: %ds", timeLeft), win.w - 200.0f, win.h - 50.0f, 0.5f, glm::vec3(1.0f));
                 if (player.enableAbilities) {
-                    auto drawDashAbility = [&](Texture& tex, float x, float y, float cool, string abilityText) {
-                        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
-                        uiShader.use();
-                        tex.bind(GL_TEXTURE0);
-                        render.drawTexture(textureMesh, uiShader, tex, model, glm::mat4(1.0f), proj, cool > 0.0f ? glm::vec4(0.2f) : glm::vec4(1.0f), true);
-                        text->draw(abilityText, x + 125.0f - abilityText.length() * 60.0f, y - 105.0f, 0.5f, glm::vec3(1.0f));
-                        };
-                    auto drawSuperJumpAbility = [&](Texture& tex, float x, float y, float cool, string abilityText) {
-                        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
-                        uiShader.use();
-                        tex.bind(GL_TEXTURE0);
-                        render.drawTexture(textureMesh, uiShader, tex, model, glm::mat4(1.0f), proj, cool > 0.0f ? glm::vec4(0.2f) : glm::vec4(1.0f), true);
-                        text->draw(abilityText, x + 110.0f - abilityText.length() * 60.0f, y - 135.0f, 0.5f, glm::vec3(1.0f));
-                        };
-                    drawDashAbility(dashTexture, win.w / 2.0f - 215.0f, 135.0f, player.getDashCool(), to_string(static_cast<int>(player.getDashCool())) + "s");
-                    drawSuperJumpAbility(superJumpTexture, win.w / 2.0f + 205.0f, 165.0f, player.getSuperJumpCool(), to_string(static_cast<int>(player.getSuperJumpCool())) + "s");
+                    Widget& dash = hudUI.widgets[dashIcon];
+                    Widget& superJump = hudUI.widgets[superJumpIcon];
+                    dash.tint = player.getDashCool() > 0.0f ? glm::vec4(0.2f) : glm::vec4(1.0f);
+                    superJump.tint = player.getSuperJumpCool() > 0.0f ? glm::vec4(0.2f) : glm::vec4(1.0f);
+                    hudUI.layout(win.w, win.h);
+                    hudUI.draw(uiBatch, whiteTexture);
+                    uiBatch.flush(uiShader, proj);
+                    const char* dashText = arena.format("%ds", static_cast<int>(player.getDashCool()));
+                    const char* superJumpText = arena.format("%ds", static_cast<int>(player.getSuperJumpCool()));
+                    text->draw(dashText, dash.rect.x + 125.0f - strlen(dashText) * 60.0f, dash.rect.y - 105.0f, 0.5f, glm::vec3(1.0f));
+                    text->draw(superJumpText, superJump.rect.x + 110.0f - strlen(superJumpText) * 60.0f, superJump.rect.y - 135.0f, 0.5f, glm::vec3(1.0f));
                 }
                 glEnable(GL_DEPTH_TEST);
             }
             else {
+                TRACE_SCOPE("end screen");
+                Texture* winPages[] = { &win1Texture, &win2Texture, &win3Texture, &win4Texture, &win5Texture };
+                endUI.widgets[endImage].tex = won ? winPages[winStoryPage] : lostStoryPage == 0 ? &lost1Texture : &lost2Texture;
+                endUI.layout(win.w, win.h);
+                endUI.draw(uiBatch, whiteTexture);
+                uiBatch.flush(uiShader, proj);
+                // Son kıvılcımlar/konfeti bitiş ekranının üstünde sönene kadar sürer
                 glDisable(GL_DEPTH_TEST);
-                Texture* tex = nullptr;
-                if (won) {
-                    if (winStoryPage == 0) tex = &win1Texture;
-                    else if (winStoryPage == 1) tex = &win2Texture; else if (winStoryPage == 2) tex = &win3Texture; else if (winStoryPage == 3) tex = &win4Texture; else if (winStoryPage == 4) tex = &win5Texture;
-                    if (winStoryPage == 4) text->draw("Press R to Restart", (win.w - 270.0f) / 2.0f, 50.0f, 0.5f, glm::vec3(1.0f));
-                    if (glfwGetKey(win.window, GLFW_KEY_SPACE) == GLFW_PRESS && !spacePressed) {
-                        spacePressed = true;
-                        if (++winStoryPage > 4) winStoryPage = 4;
-                    }
-                    if (winStoryPage == 4 && glfwGetKey(win.window, GLFW_KEY_R) == GLFW_PRESS) {
-                        player.pos = glm::vec3(0.0f, 0.5f, 0.0f);
-                        ai.pos = glm::vec3(8.0f, 0.5f, 8.0f);
-                        gameTime = 0.0f;
-                        over = won = false;
-                        inMenu = true;
-                        winStoryPage = 0;
-                        glfwSetInputMode(win.window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-                        cam.firstMouse = true;
-                    }
+                particles.update(particleUpdateShader, dt, lastTime);
+                particles.draw(particleShader, cam.view, cam.proj, static_cast<float>(win.h), lastTime);
+                glEnable(GL_DEPTH_TEST);
+                bool lastPage = won ? winStoryPage == 4 : lostStoryPage == 1;
+                if (lastPage) {
+                    glDisable(GL_DEPTH_TEST);
+                    text->draw("Press R to Restart", (win.w - 270.0f) / 2.0f, 50.0f, 0.5f, glm::vec3(1.0f));
+                    glEnable(GL_DEPTH_TEST);
                 }
-                else {
-                    tex = lostStoryPage == 0 ? &lost1Texture : &lost2Texture;
-                    if (lostStoryPage == 1) text->draw("Press R to Restart", (win.w - 270.0f) / 2.0f, 50.0f, 0.5f, glm::vec3(1.0f));
-                    if (glfwGetKey(win.window, GLFW_KEY_SPACE) == GLFW_PRESS && !spacePressed) {
-                        spacePressed = true;
-                        if (++lostStoryPage > 1) lostStoryPage = 1;
-                    }
-                    if (lostStoryPage == 1 && glfwGetKey(win.window, GLFW_KEY_R) == GLFW_PRESS) {
-                        player.pos = glm::vec3(0.0f, 0.5f, 0.0f);
-                        ai.pos = glm::vec3(8.0f, 0.5f, 8.0f);
-                        gameTime = 0.0f;
-                        over = won = false;
-                        inMenu = true;
-                        lostStoryPage = 0;
-                        glfwSetInputMode(win.window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-                        cam.firstMouse = true;
-                    }
+                if (won) {
+                    if (input.pressed(GLFW_KEY_SPACE) && ++winStoryPage > 4) winStoryPage = 4;
                 }
-                if (tex) drawUI(*tex, win.w / 2.0f, win.h / 2.0f, (float)win.w, (float)win.h);
-                if (glfwGetKey(win.window, GLFW_KEY_SPACE) == GLFW_RELEASE) spacePressed = false;
+                else if (input.pressed(GLFW_KEY_SPACE) && ++lostStoryPage > 1) lostStoryPage = 1;
+                if (lastPage && input.pressed(GLFW_KEY_R)) restart();
+            }
+            latency.report(lastTime, showLatency);
+            if (showLatency) {
+                glDisable(GL_DEPTH_TEST);
+                text->draw(latency.overlay, 10.0f, win.h - 25.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+                text->draw(arena.format("3D scale %d%% (%dx%d), %.2f ms at 100%%", static_cast<int>(dynres.scale * 100.0f + 0.5f), dynres.w, dynres.h, dynres.costPerArea),
+                    10.0f, win.h - 45.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
+                StreamBuffer& stream = StreamBuffer::current();
+                text->draw(arena.format("Crowd %zu: %.3f ms on %d threads | stream %s %zu KB, %zu stalls, %zu orphans | %zu matrices rebuilt", crowd.positions.size(), crowdMs,
+                    JobSystem::current().size(), stream.persistent ? "persistent" : "unsynchronized", stream.size >> 10, stream.stalls, stream.orphans, Transform::rebuilds()),
+                    10.0f, win.h - 65.0f, 0.35f, glm::vec3(1.0f, 1.0f, 0.0f));
                 glEnable(GL_DEPTH_TEST);
             }
+            // Takas vsync'te bekleyebilir; öncesinde de yoklayarak render sırasında gelen olaylara doğru zaman damgası ver
+            win.poll();
+            capture.grab(win.target);
+            latency.beforeSwap();
             win.swap();
+            latency.afterSwap();
             win.poll();
+
+            // Isınma (ilk 120 oyun karesi: tamponlar büyür, sürücü kaynakları oluşur) sonrasında oyun kareleri heap'e dokunmamalı
+            size_t allocs = heapAllocCount.load(std::memory_order_relaxed) - allocsAtStart;
+            if (gameplayFrame && ++gameplayFrames > 120 && allocs > 0 && allocCheck) {
+                ++allocFailures;
+                cout << "alloc-check: gameplay frame " << gameplayFrames << " made " << allocs << " heap allocations" << endl;
+            }
+            ++frame;
         }
+        if (allocCheck)
+            cout << "alloc-check: " << gameplayFrames << " gameplay frames, " << allocFailures << " allocating, arena peak " << arena.peak
+                << " bytes, " << arena.overflows << " overflows" << endl;
+        if (traceOnExit && Trace::dump(tracePath, traceSeconds)) cout << "Trace: last " << traceSeconds << " s written to " << tracePath << endl;
     }
 };
 
-int main() {
+static bool hasArg(int argc, char** argv, const char* name) {
+    for (int i = 1; i < argc; ++i) if (strcmp(argv[i], name) == 0) return true;
+    return false;
+}
+
+static const char* argValue(int argc, char** argv, const char* name, const char* def) {
+    for (int i = 1; i + 1 < argc; ++i) if (strcmp(argv[i], name) == 0) return argv[i + 1];
+    return def;
+}
+
+int main(int argc, char** argv) {
+    Trace::enabled() = !hasArg(argc, argv, "--no-trace");
+    TRACE_THREAD("main");
+    if (hasArg(argc, argv, "--bake-font")) {
+        // Araç modu: pencere açmadan SDF yazı atlasını üretir
+        return TextRenderer::bake(argValue(argc, argv, "--bake-font", ""), argValue(argc, argv, "--font-out", "fonts/ui.sdf"),
+            atoi(argValue(argc, argv, "--font-size", "48")));
+    }
+    // Araç modları: iş sisteminin yarış denetimi ve 1..N iş parçacığı ölçeklenme kıyaslaması
+    if (hasArg(argc, argv, "--jobs-test")) return JobSystem::selfTest() ? 1 : 0;
+    if (hasArg(argc, argv, "--jobs-bench")) {
+        const char* threads = argValue(argc, argv, "--jobs-bench", "64");
+        JobSystem::benchmark(glm::clamp(threads[0] == '-' ? 64 : atoi(threads), 1, static_cast<int>(JobSystem::MAX_WORKERS)));
+        return 0;
+    }
+    // Ortak iş sistemi: varsayılan çekirdek sayısı - 1 işçi (çağıran iş parçacığı da iş yürütür); sunucu da kullanır
+    int workers = glm::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+    if (hasArg(argc, argv, "--workers")) workers = glm::clamp(atoi(argValue(argc, argv, "--workers", "0")), 0, JobSystem::MAX_WORKERS - 1);
+    JobSystem::current().start(workers);
+    uint16_t port = static_cast<uint16_t>(atoi(argValue(argc, argv, "--port", "27015")));
+    if (hasArg(argc, argv, "--pack")) {
+        // Araç modu: manifestteki varlıkları tek arşive toplar
+        const char* out = argValue(argc, argv, "--pack", "assets.pak");
+        return AssetPack::build(argValue(argc, argv, "--manifest", "assets.manifest"), out[0] == '-' ? "assets.pak" : out, hasArg(argc, argv, "--pack-compressed"));
+    }
+    // Tek açılış: varlıklar paketten kopyasız okunur, paket yoksa gevşek dosyalara düşülür
+    if (AssetPack::current().open(argValue(argc, argv, "--assets", "assets.pak")))
+        cout << "Assets: " << AssetPack::current().count << " from pack" << endl;
+    // Sunucu ve istemciler aynı arenayı yüklemeli: çarpışma her iki tarafta da aynı SDF'den okunur
+    ArenaMap::current().load(argValue(argc, argv, "--arena", "classic"));
+    if (hasArg(argc, argv, "--server")) {
+        GameServer server(static_cast<float>(atof(argValue(argc, argv, "--tick", "60"))), atoi(argValue(argc, argv, "--chasers", "4")));
+        server.scheduler.budgetMs = static_cast<float>(atof(argValue(argc, argv, "--ai-budget", "1")));
+        return server.run(port);
+    }
+    if (hasArg(argc, argv, "--loadgen")) {
+        return LoadGenerator::run(atoi(argValue(argc, argv, "--loadgen", "16")), port, static_cast<float>(atof(argValue(argc, argv, "--seconds", "30"))));
+    }
+
+    bool headless = hasArg(argc, argv, "--headless");
+    // Kalite: --quality bu oturum için; settings.cfg yoksa (ya da --benchmark) oyun menüden önce kıyaslayıp kaydeder.
+    // Ekransız kayıtlar makineden bağımsız kalsın diye kıyaslama yapmaz
+    Settings& settings = Settings::current();
+    bool haveSettings = settings.load();
+    QualitySettings::Preset preset;
+    bool runBenchmark = false;
+    if (hasArg(argc, argv, "--quality") && QualitySettings::parse(argValue(argc, argv, "--quality", "high"), preset))
+        settings.quality = QualitySettings::make(preset);
+    else runBenchmark = (!haveSettings || hasArg(argc, argv, "--benchmark")) && !headless;
+    Window::offscreen() = headless;
     Game game;
+    game.particles.init(atoi(argValue(argc, argv, "--particles", "1048576")));
+    if (hasArg(argc, argv, "--target-fps")) game.dynres.targetMs = 1000.0f / glm::max(1.0f, static_cast<float>(atof(argValue(argc, argv, "--target-fps", "60"))));
+    if (runBenchmark) {
+        preset = game.benchmark(game.dynres.targetMs);
+        settings.quality = QualitySettings::make(preset);
+        settings.save();
+        game.applyQuality(settings.quality);
+        cout << "Quality: " << QualitySettings::name(preset) << " (saved to settings.cfg)" << endl;
+    }
+    if (hasArg(argc, argv, "--spectators")) game.spectatorCount = static_cast<size_t>(glm::max(atoi(argValue(argc, argv, "--spectators", "50")), 0));
+    if (hasArg(argc, argv, "--vsync")) glfwSwapInterval(atoi(argValue(argc, argv, "--vsync", "1")));
+    game.frameCap = atof(argValue(argc, argv, "--fps-cap", "0"));
+    game.showLatency = hasArg(argc, argv, "--latency");
+    if (hasArg(argc, argv, "--render-scale")) // Sabit ölçek: otomatik ayar kapanır
+        game.dynres.scale = game.dynres.minScale = game.dynres.maxScale = glm::clamp(static_cast<float>(atof(argValue(argc, argv, "--render-scale", "1"))), 0.25f, 1.0f);
+    if (hasArg(argc, argv, "--alloc-check")) {
+        // Menüleri atlayıp doğrudan oyuna gir; --frames kare sonra çık, heap'ten ayıran kare varsa başarısız dön
+        game.allocCheck = true;
+        game.frameLimit = atoi(argValue(argc, argv, "--frames", "600"));
+        game.inMenu = false;
+        glfwSetInputMode(game.win.window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    }
+    if (hasArg(argc, argv, "--trace")) {
+        game.tracePath = argValue(argc, argv, "--trace", "trace.json");
+        if (game.tracePath[0] == '-') game.tracePath = "trace.json";
+        game.traceOnExit = true;
+    }
+    game.traceSeconds = atof(argValue(argc, argv, "--trace-seconds", "10"));
+    if (hasArg(argc, argv, "--seed")) game.seed = strtoull(argValue(argc, argv, "--seed", "1"), nullptr, 10);
+    if (headless) {
+        // Ekransız kayıt: menüler atlanır, saat sabit adımla ilerler, çözünürlük ölçeği GPU süresine göre oynamaz
+        game.fixedStep = 1.0 / glm::max(1, atoi(argValue(argc, argv, "--capture-fps", "60")));
+        if (!hasArg(argc, argv, "--seed")) game.seed = 1;
+        if (!game.frameLimit) game.frameLimit = atoi(argValue(argc, argv, "--frames", "600"));
+        if (!hasArg(argc, argv, "--render-scale")) game.dynres.scale = game.dynres.minScale = game.dynres.maxScale = 1.0f;
+        game.inMenu = false;
+    }
+    if (hasArg(argc, argv, "--capture") &&
+        !game.capture.start(argValue(argc, argv, "--capture", "capture.y4m"), game.win.w, game.win.h, atoi(argValue(argc, argv, "--capture-fps", "60"))))
+        std::cerr << "Cannot start capture" << std::endl;
+    if (hasArg(argc, argv, "--connect") && !game.connect(argValue(argc, argv, "--connect", "127.0.0.1"), port))
+        std::cerr << "Failed to open client socket" << std::endl;
     game.run();
-    return 0;
+    return game.allocFailures ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 330 core
+// Instance: xyz pozisyon, w kullanilmiyor
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aTexCoord;
+layout(location=2) in vec4 aInstance;
+out vec2 TexCoord;
+uniform mat4 view, projection;
+uniform vec3 camRight;
+uniform float scale;
+
+void main() {
+    vec3 p = aInstance.xyz + (camRight * aPos.x + vec3(0.0, aPos.y, 0.0)) * scale;
+    gl_Position = projection * view * vec4(p, 1.0);
+    TexCoord = aTexCoord;
+}
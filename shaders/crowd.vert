@@ -0,0 +1,15 @@
+#version 330 core
+// Instance: xyz pozisyon, w yaw
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aTexCoord;
+layout(location=2) in vec4 aInstance;
+out vec2 TexCoord;
+uniform mat4 view, projection;
+uniform float scale;
+
+void main() {
+    vec3 p = aPos * scale;
+    float c = cos(aInstance.w), s = sin(aInstance.w);
+    gl_Position = projection * view * vec4(vec3(c * p.x + s * p.z, p.y, -s * p.x + c * p.z) + aInstance.xyz, 1.0);
+    TexCoord = aTexCoord;
+}
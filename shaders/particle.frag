@@ -0,0 +1,9 @@
+#version 330 core
+in vec4 Color;
+out vec4 color;
+
+void main() {
+    vec2 d = gl_PointCoord * 2.0 - 1.0;
+    if (dot(d, d) > 1.0) discard;
+    color = Color;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+// Parcaciklar nokta olarak cizilir; olu olanlar kirpma alaninin disina atilir
+layout(location=0) in vec4 posLife;
+layout(location=1) in vec4 velKind;
+out vec4 Color;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float pointScale; // Viewport yuksekligi * projection[1][1] / 2
+
+vec3 hue(float h) {
+    return clamp(abs(fract(h + vec3(0.0, 2.0 / 3.0, 1.0 / 3.0)) * 6.0 - 3.0) - 1.0, 0.0, 1.0);
+}
+
+void main() {
+    if (posLife.w <= 0.0) { gl_Position = vec4(2.0, 2.0, 2.0, 1.0); gl_PointSize = 0.0; Color = vec4(0.0); return; }
+    int kind = int(velKind.w);
+    float tint = fract(velKind.w), fade = clamp(posLife.w * 2.0, 0.0, 1.0), size = 0.06;
+    if (kind == 0) Color = vec4(mix(vec3(0.6, 0.9, 1.0), vec3(1.0), tint), fade * 0.6);
+    else if (kind == 1) { Color = vec4(mix(vec3(0.35, 0.3, 0.25), vec3(0.3, 1.0, 0.4), tint * tint), fade); size = 0.08; }
+    else if (kind == 2) { Color = vec4(hue(tint), 1.0); size = 0.12; }
+    else Color = vec4(1.0, tint * 0.6, 0.1, fade);
+    vec4 eye = view * vec4(posLife.xyz, 1.0);
+    gl_Position = projection * eye;
+    gl_PointSize = clamp(size * pointScale / max(-eye.z, 0.1), 1.0, 64.0);
+}
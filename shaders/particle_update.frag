@@ -0,0 +1,7 @@
+#version 330 core
+// Benzetim gecisi GL_RASTERIZER_DISCARD ile cizilir; bu parca asla calismaz
+out vec4 color;
+
+void main() {
+    color = vec4(0.0);
+}
@@ -0,0 +1,61 @@
+#version 330 core
+// Parcacik benzetimi: her yuva bir kez islenir, sonuc transform feedback ile diger tampona yazilir.
+// Yayim da burada: halka imlecinden itibaren emitter araliklarina dusen yuvalar yeniden dogar.
+layout(location=0) in vec4 posLife;   // xyz konum, w kalan omur (<= 0: olu)
+layout(location=1) in vec4 velKind;   // xyz hiz, w tur (0 dash, 1 enkaz, 2 konfeti, 3 yakalanma)
+out vec4 outPosLife;
+out vec4 outVelKind;
+
+const int MAX_EMITTERS = 8;
+uniform int capacity, cursor, emitterCount;
+uniform float dt;
+uniform uint seed;
+uniform vec4 emitPos[MAX_EMITTERS];   // xyz merkez, w tur
+uniform vec4 emitVel[MAX_EMITTERS];   // xyz temel hiz, w rastgele hiz
+uniform vec4 emitShape[MAX_EMITTERS]; // x halka yaricapi, y omur, z baslangic, w adet
+uniform float floorY;
+
+uint hash(uint x) {
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float rand(inout uint state) {
+    state = hash(state);
+    return float(state & 0xFFFFFFu) / 16777215.0;
+}
+
+void main() {
+    vec4 p = posLife, v = velKind;
+    int offset = (gl_VertexID - cursor + capacity) % capacity;
+    for (int e = 0; e < emitterCount; ++e) {
+        int begin = int(emitShape[e].z), count = int(emitShape[e].w);
+        if (offset < begin || offset >= begin + count) continue;
+        uint state = hash(uint(gl_VertexID) ^ seed);
+        float angle = rand(state) * 6.2831853;
+        vec3 radial = vec3(cos(angle), 0.0, sin(angle));
+        vec3 jitter = vec3(rand(state), rand(state), rand(state)) * 2.0 - 1.0;
+        p.xyz = emitPos[e].xyz + radial * emitShape[e].x + jitter * 0.1;
+        p.w = emitShape[e].y * (0.5 + 0.5 * rand(state));
+        v.xyz = emitVel[e].xyz + (radial * (emitShape[e].x > 0.0 ? 1.0 : 0.0) + jitter) * emitVel[e].w;
+        v.w = emitPos[e].w + fract(rand(state)) * 0.99; // Tam kisim tur, kesir renk tohumu
+        outPosLife = p;
+        outVelKind = v;
+        return;
+    }
+
+    if (p.w > 0.0) {
+        int kind = int(v.w);
+        float gravity = kind == 0 ? 0.5 : kind == 2 ? 2.0 : 9.8;
+        float drag = kind == 2 ? 1.5 : kind == 0 ? 3.0 : 0.3;
+        v.y -= gravity * dt;
+        v.xyz *= max(1.0 - drag * dt, 0.0);
+        p.xyz += v.xyz * dt;
+        if (p.y < floorY && kind != 2) { p.y = floorY; v.y = -v.y * 0.4; v.xz *= 0.7; }
+        p.w -= dt;
+    }
+    outPosLife = p;
+    outVelKind = v;
+}
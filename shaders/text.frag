@@ -0,0 +1,12 @@
+#version 330 core
+// SDF atlasi: 0.5 glif kenari; gecis genisligi ekrandaki bir pikselin alan degisimi kadar, her olcekte keskin
+in vec2 TexCoords;
+out vec4 color;
+uniform sampler2D text;
+uniform vec3 textColor;
+
+void main() {
+    float d = texture(text, TexCoords).r;
+    float w = max(fwidth(d) * 0.7, 1e-4);
+    color = vec4(textColor, smoothstep(0.5 - w, 0.5 + w, d));
+}
@@ -0,0 +1,9 @@
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+uniform sampler2D texture1;
+uniform vec4 colorTint;
+
+void main() {
+    FragColor = texture(texture1, TexCoord) * colorTint;
+}
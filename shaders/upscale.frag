@@ -0,0 +1,20 @@
+#version 330 core
+// Cift dogrusal buyutme + 4 komsulu keskinlestirme (sharpness 0: yalniz cift dogrusal)
+in vec2 TexCoord;
+out vec4 FragColor;
+uniform sampler2D scene;
+uniform vec2 uvScale;
+uniform vec2 texel;
+uniform float sharpness;
+
+vec3 fetch(vec2 uv) {
+    // Cizilen alanin disindaki eski pikseller karisamasin
+    return texture(scene, clamp(uv, texel * 0.5, uvScale - texel * 0.5)).rgb;
+}
+
+void main() {
+    vec3 c = fetch(TexCoord);
+    vec3 n = fetch(TexCoord + vec2(texel.x, 0.0)) + fetch(TexCoord - vec2(texel.x, 0.0)) +
+             fetch(TexCoord + vec2(0.0, texel.y)) + fetch(TexCoord - vec2(0.0, texel.y));
+    FragColor = vec4(clamp(c + (c * 4.0 - n) * (sharpness * 0.25), 0.0, 1.0), 1.0);
+}
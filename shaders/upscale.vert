@@ -0,0 +1,10 @@
+#version 330 core
+// Tam ekran ucgen, tampon gerekmez; uvScale FBO'nun cizilen alt dikdortgeni
+out vec2 TexCoord;
+uniform vec2 uvScale;
+
+void main() {
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+    TexCoord = p * uvScale;
+}